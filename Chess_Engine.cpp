@@ -159,10 +159,154 @@ namespace Time
 
 namespace Perft {
 
-    long nodes;
+    long long nodes;
+
+    // bulk counting: count leaf nodes by the number of legal moves at depth 1
+    // instead of making every leaf move (turn it off to time make/unmake)
+    int bulk_counting = 1;
+
+    // perft hash table entry (subtree node count of a position searched to a given depth),
+    // parallel perft threads share the table without locking: the key is stored xor-ed with
+    // the data, so an entry torn by two threads writing it at once matches no position
+    typedef struct {
+        std::atomic<U64> key;   // full hash key of the position ^ data
+        std::atomic<U64> data;  // subtree node count (low 56 bits) | perft depth (high 8 bits)
+    } PerftEntry;
+
+    // perft hash table (optional, disabled when there are no entries)
+    PerftEntry* perft_hash_table = NULL;
+    long perft_hash_entries = 0;
+
+    // verify hashed perft divide against unhashed perft
+    int verify_hash = 0;
+
+    // (re)allocate perft hash table of given size in megabytes (0 disables hashing)
+    void init_perft_hash(int megabytes)
+    {
+        // free previous table
+        free(perft_hash_table);
+        perft_hash_table = NULL;
+        perft_hash_entries = 0;
+
+        // hashing disabled
+        if (megabytes <= 0)
+            return;
+
+        // allocate cleared entries
+        long entries = (long)((megabytes * 0x100000ULL) / sizeof(PerftEntry));
+        perft_hash_table = (PerftEntry*)calloc(entries, sizeof(PerftEntry));
+
+        // out of memory, hashing stays disabled
+        if (perft_hash_table == NULL)
+        {
+            printf("info string perft hash: can't allocate %d MB\n", megabytes);
+            return;
+        }
+
+        perft_hash_entries = entries;
+    }
+
+    // clear perft hash table
+    void clear_perft_hash()
+    {
+        for (long index = 0; index < perft_hash_entries; index++)
+        {
+            perft_hash_table[index].key.store(0, std::memory_order_relaxed);
+            perft_hash_table[index].data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // probe perft hash table, returns stored subtree node count (-1 if position isn't stored)
+    static long long probe_perft_hash(U64 hash_key, int depth)
+    {
+        PerftEntry& entry = perft_hash_table[hash_key % perft_hash_entries];
+
+        // load data before key (a torn entry fails the key check)
+        U64 data = entry.data.load(std::memory_order_relaxed);
+        U64 key = entry.key.load(std::memory_order_relaxed);
+
+        // same position at the same depth
+        if ((key ^ data) != hash_key || (int)(data >> 56) != depth)
+            return -1;
+
+        return (long long)(data & 0xffffffffffffffULL);
+    }
+
+    // store subtree node count in perft hash table (always replace)
+    static void store_perft_hash(U64 hash_key, int depth, long long nodes)
+    {
+        PerftEntry& entry = perft_hash_table[hash_key % perft_hash_entries];
+
+        U64 data = (U64)nodes | (U64)depth << 56;
+        entry.key.store(hash_key ^ data, std::memory_order_relaxed);
+        entry.data.store(data, std::memory_order_relaxed);
+    }
 
     // perft driver
-    void perft_driver(int depth)
+    void perft_driver(Position& pos, int depth)
+    {
+        // reccursion escape condition
+        if (depth == 0)
+        {
+            // increment nodes count (count reached positions)
+            nodes++;
+            return;
+        }
+
+        // probe perft hash table (depth 1 is cheaper to count than to look up)
+        int use_hash = perft_hash_entries && depth > 1;
+
+        if (use_hash)
+        {
+            // same position at the same depth, take the stored subtree node count
+            long long hash_nodes = probe_perft_hash(pos.hash_key, depth);
+
+            if (hash_nodes >= 0)
+            {
+                nodes += hash_nodes;
+                return;
+            }
+        }
+
+        // nodes count before searching the subtree
+        long long start_nodes = nodes;
+
+        // create move list instance
+        MoveGeneration::MoveList move_list;
+
+        // generate moves
+        MoveGeneration::generate_moves(pos, move_list);
+
+        // moves are generated legal, so the leaves are just counted
+        if (depth == 1 && bulk_counting)
+        {
+            nodes += move_list.count;
+            return;
+        }
+
+        // loop over generated moves
+        for (int move_count = 0; move_count < move_list.count; move_count++)
+        {
+            // undo record of the move
+            MoveGeneration::Undo undo;
+
+            // make move (moves are generated legal)
+            MoveGeneration::make_move(pos, move_list.moves[move_count], undo);
+
+            // call perft driver recursively
+            perft_driver(pos, depth - 1);
+
+            // take back
+            MoveGeneration::unmake_move(pos, move_list.moves[move_count], undo);
+        }
+
+        // store subtree node count
+        if (use_hash)
+            store_perft_hash(pos.hash_key, depth, nodes - start_nodes);
+    }
+
+    // perft driver taking moves back by copy-make (reference for the make/unmake bench)
+    void perft_copy_driver(Position& pos, int depth)
     {
         // reccursion escape condition
         if (depth == 0)
@@ -173,24 +317,23 @@ namespace Perft {
         }
 
         // create move list instance
-        std::vector<int> move_list;
+        MoveGeneration::MoveList move_list;
 
         // generate moves
-        MoveGeneration::generate_moves(move_list);
+        MoveGeneration::generate_moves(pos, move_list);
 
         // loop over generated moves
-        for (int move_count = 0; move_count < move_list.size(); move_count++)
+        for (int move_count = 0; move_count < move_list.count; move_count++)
         {
             // preserve board state
             copy_board();
 
-            // make move
-            if (!make_move(move_list[move_count], MoveGeneration::all_moves))
-                // skip to the next move
-                continue;
+            // make move (undo record is not needed)
+            MoveGeneration::Undo undo;
+            MoveGeneration::make_move(pos, move_list.moves[move_count], undo);
 
             // call perft driver recursively
-            perft_driver(depth - 1);
+            perft_copy_driver(pos, depth - 1);
 
             // take back
             take_back();
@@ -198,56 +341,326 @@ namespace Perft {
     }
 
     // perft test
-    void perft_test(int depth)
+    void perft_test(Position& pos, int depth)
     {
         std::cout<<"\n     Performance test\n\n";
 
         // create move list instance
-        std::vector<int> move_list;
+        MoveGeneration::MoveList move_list;
 
         // generate moves
-        MoveGeneration::generate_moves(move_list);
+        MoveGeneration::generate_moves(pos, move_list);
 
 
          // init start time
         long start = Time::get_time_ms();
 
         // loop over generated moves
-        for (int move_count = 0; move_count < move_list.size(); move_count++)
+        for (int move_count = 0; move_count < move_list.count; move_count++)
         {
-            // preserve board state
-            copy_board();
+            // undo record of the move
+            MoveGeneration::Undo undo;
 
-            // make move
-            if (!MoveGeneration::make_move(move_list[move_count], MoveGeneration::all_moves))
-                // skip to the next move
-                continue;
+            // make move (moves are generated legal)
+            MoveGeneration::make_move(pos, move_list.moves[move_count], undo);
 
             // cummulative nodes
-            long cummulative_nodes = nodes;
+            long long cummulative_nodes = nodes;
 
             // call perft driver recursively
-            perft_driver(depth - 1);
+            perft_driver(pos, depth - 1);
 
             // old nodes
-            long old_nodes = nodes - cummulative_nodes;
+            long long old_nodes = nodes - cummulative_nodes;
 
             // take back
-            take_back();
+            MoveGeneration::unmake_move(pos, move_list.moves[move_count], undo);
 
             // print move
-            std::cout<<"     move: "<< square_to_coordinates[get_move_source(move_list[move_count])]<<
-                square_to_coordinates[get_move_target(move_list[move_count])]<<
-                (get_move_promoted(move_list[move_count]) ? MoveGeneration::promoted_pieces[get_move_promoted(move_list[move_count])] : ' ')<<
+            std::cout<<"     move: "<< square_to_coordinates[get_move_source(move_list.moves[move_count])]<<
+                square_to_coordinates[get_move_target(move_list.moves[move_count])]<<
+                (get_move_promoted(move_list.moves[move_count]) ? MoveGeneration::promoted_pieces[get_move_promoted(move_list.moves[move_count])] : ' ')<<
                 "      nodes:  "<<old_nodes<<"\n";
         }
 
+        // elapsed time
+        long time = Time::get_time_ms() - start;
+
         // print results
         std::cout << "\n    Depth: " << depth << "\n";
         std::cout << "    Nodes: " << nodes << "\n\n";
-        std::cout << "    Time: " << Time::get_time_ms() - start  << "\n";
+        std::cout << "    Time: " << time << "\n";
+        std::cout << "    NPS: " << (time ? nodes * 1000 / time : 0) << (bulk_counting ? " (bulk counting)" : "") << (perft_hash_entries ? " (hashed)" : "") << "\n";
         
     }
+
+    /*
+        Parallel perft
+
+        root moves load-balance badly (their subtrees differ a lot in size), so the tree
+        is split two plies below the root into tasks, which are dealt out to per-thread
+        queues in tree order, owner thread takes tasks from the front of its queue and,
+        once it's empty, steals from the back of the other queues
+    */
+
+    // max number of perft threads
+    #define max_perft_threads 64
+
+    // max number of parallel perft tasks (root moves * replies, root moves that don't fit
+    // are split one ply below the root)
+    #define max_perft_tasks 65536
+
+    // number of perft threads (all hardware threads)
+    int perft_threads()
+    {
+        int threads = (int)std::thread::hardware_concurrency();
+        if (threads < 1) threads = 1;
+        if (threads > max_perft_threads) threads = max_perft_threads;
+        return threads;
+    }
+
+    // parallel perft task (subtree reached by one or two moves from the root)
+    typedef struct {
+        int root_index;     // index of the root move (for divide counts)
+        int moves[2];       // moves leading from the root to the subtree (0 if not used)
+        int depth;          // perft depth left in the subtree
+    } PerftTask;
+
+    // work-stealing queue of a perft thread (tasks in [head, tail) range of the task array)
+    typedef struct {
+        std::mutex lock;    // guards head & tail
+        int head;           // next task of the owner thread
+        int tail;           // end of the range (thieves take tasks from here)
+    } PerftQueue;
+
+    // parallel perft tasks & per-thread queues
+    PerftTask perft_tasks[max_perft_tasks];
+    PerftQueue perft_queues[max_perft_threads];
+
+    // node counts by root move & total node count (updated by all threads)
+    std::atomic<long long> divide_nodes[256];
+    std::atomic<long long> parallel_nodes;
+
+    // count perft nodes of a subtree (thread safe, doesn't use global node counter)
+    long long perft_count(Position& pos, int depth)
+    {
+        // reccursion escape condition
+        if (depth == 0)
+            return 1;
+
+        // probe perft hash table (depth 1 is cheaper to count than to look up)
+        int use_hash = perft_hash_entries && depth > 1;
+
+        if (use_hash)
+        {
+            long long hash_nodes = probe_perft_hash(pos.hash_key, depth);
+            if (hash_nodes >= 0) return hash_nodes;
+        }
+
+        // create move list instance
+        MoveGeneration::MoveList move_list;
+
+        // generate moves
+        MoveGeneration::generate_moves(pos, move_list);
+
+        // moves are generated legal, so the leaves are just counted
+        if (depth == 1 && bulk_counting)
+            return move_list.count;
+
+        // subtree node count
+        long long count = 0;
+
+        // loop over generated moves
+        for (int move_count = 0; move_count < move_list.count; move_count++)
+        {
+            MoveGeneration::Undo undo;
+            MoveGeneration::make_move(pos, move_list.moves[move_count], undo);
+            count += perft_count(pos, depth - 1);
+            MoveGeneration::unmake_move(pos, move_list.moves[move_count], undo);
+        }
+
+        // store subtree node count
+        if (use_hash)
+            store_perft_hash(pos.hash_key, depth, count);
+
+        return count;
+    }
+
+    // take next task for the thread (own queue first, then steal), returns 0 when all the work is done
+    static int take_task(int thread, int threads, PerftTask& task)
+    {
+        // loop over own queue followed by other threads' queues
+        for (int offset = 0; offset < threads; offset++)
+        {
+            // init queue
+            PerftQueue& queue = perft_queues[(thread + offset) % threads];
+            std::lock_guard<std::mutex> guard(queue.lock);
+
+            // queue is empty
+            if (queue.head >= queue.tail)
+                continue;
+
+            // owner takes the front task, thieves take the back one
+            task = offset ? perft_tasks[--queue.tail] : perft_tasks[queue.head++];
+            return 1;
+        }
+
+        // no tasks left
+        return 0;
+    }
+
+    // perft thread searching tasks on its own copy of the root position
+    static void perft_thread(const Position& root, int thread, int threads)
+    {
+        // per-thread position
+        Position pos = root;
+
+        // current task
+        PerftTask task;
+
+        // loop over tasks
+        while (take_task(thread, threads, task))
+        {
+            // make moves leading to the subtree
+            MoveGeneration::Undo undo[2];
+            MoveGeneration::make_move(pos, task.moves[0], undo[0]);
+            if (task.moves[1]) MoveGeneration::make_move(pos, task.moves[1], undo[1]);
+
+            // count subtree nodes
+            long long count = perft_count(pos, task.depth);
+
+            // take moves back
+            if (task.moves[1]) MoveGeneration::unmake_move(pos, task.moves[1], undo[1]);
+            MoveGeneration::unmake_move(pos, task.moves[0], undo[0]);
+
+            // update shared node counts
+            divide_nodes[task.root_index] += count;
+            parallel_nodes += count;
+        }
+    }
+
+    // parallel perft of given depth on given number of threads (divide counts are left in divide_nodes)
+    long long parallel_perft(Position& pos, int depth, int threads, MoveGeneration::MoveList& root_moves)
+    {
+        // clamp number of threads
+        if (threads < 1) threads = 1;
+        if (threads > max_perft_threads) threads = max_perft_threads;
+
+        // generate root moves
+        MoveGeneration::generate_moves(pos, root_moves);
+
+        // reset node counts
+        parallel_nodes = 0;
+        for (int index = 0; index < root_moves.count; index++)
+            divide_nodes[index] = 0;
+
+        // number of tasks
+        int task_count = 0;
+
+        // split the tree into tasks
+        for (int index = 0; index < root_moves.count; index++)
+        {
+            int move = root_moves.moves[index];
+
+            // depth 1: root moves are the leaves
+            if (depth <= 1)
+            {
+                divide_nodes[index] = 1;
+                parallel_nodes += 1;
+            }
+
+            // depth 2: one task per root move
+            else if (depth == 2)
+                perft_tasks[task_count++] = { index, { move, 0 }, 1 };
+
+            // deeper: one task per reply to the root move
+            else
+            {
+                MoveGeneration::Undo undo;
+                MoveGeneration::make_move(pos, move, undo);
+
+                MoveGeneration::MoveList replies;
+                MoveGeneration::generate_moves(pos, replies);
+
+                // replies don't fit (keep a task for each remaining root move): one task for the root move
+                if (task_count + replies.count + (root_moves.count - index - 1) > max_perft_tasks)
+                    perft_tasks[task_count++] = { index, { move, 0 }, depth - 1 };
+
+                else
+                {
+                    for (int reply = 0; reply < replies.count; reply++)
+                        perft_tasks[task_count++] = { index, { move, replies.moves[reply] }, depth - 2 };
+                }
+
+                MoveGeneration::unmake_move(pos, move, undo);
+            }
+        }
+
+        // deal the tasks out to the queues in contiguous ranges
+        for (int thread = 0; thread < threads; thread++)
+        {
+            perft_queues[thread].head = (int)((long long)task_count * thread / threads);
+            perft_queues[thread].tail = (int)((long long)task_count * (thread + 1) / threads);
+        }
+
+        // start helper threads, current thread works as thread 0
+        std::thread helpers[max_perft_threads];
+
+        for (int thread = 1; thread < threads; thread++)
+            helpers[thread] = std::thread(perft_thread, std::cref(pos), thread, threads);
+
+        perft_thread(pos, 0, threads);
+
+        // wait for helper threads
+        for (int thread = 1; thread < threads; thread++)
+            helpers[thread].join();
+
+        // return total node count
+        return parallel_nodes;
+    }
+
+    // perft divide on all threads ("move: nodes" lines & total, as perft tools expect)
+    void perft_divide(Position& pos, int depth)
+    {
+        // root moves
+        MoveGeneration::MoveList root_moves;
+
+        // run parallel perft
+        int threads = perft_threads();
+        long start = Time::get_time_ms();
+        long long total = parallel_perft(pos, depth, threads, root_moves);
+        long time = Time::get_time_ms() - start;
+
+        // print divide counts
+        for (int index = 0; index < root_moves.count; index++)
+        {
+            int move = root_moves.moves[index];
+
+            printf("%s%s", square_to_coordinates[get_move_source(move)].c_str(), square_to_coordinates[get_move_target(move)].c_str());
+
+            if (get_move_promoted(move))
+                printf("%c", MoveGeneration::promoted_pieces[get_move_promoted(move)]);
+
+            printf(": %lld\n", (long long)divide_nodes[index]);
+        }
+
+        // print total
+        printf("\nNodes searched: %lld\n", total);
+        printf("info string perft depth %d nodes %lld time %ld nps %lld threads %d bulk %s hash %s\n",
+            depth, total, time, time ? total * 1000 / time : 0, threads, bulk_counting ? "on" : "off", perft_hash_entries ? "on" : "off");
+
+        // compare hashed node count against unhashed perft
+        if (verify_hash && perft_hash_entries)
+        {
+            // run perft with hashing temporarily disabled
+            long entries = perft_hash_entries;
+            perft_hash_entries = 0;
+            long long unhashed = parallel_perft(pos, depth, threads, root_moves);
+            perft_hash_entries = entries;
+
+            printf("info string perft hash verification %s unhashed nodes %lld\n", unhashed == total ? "ok" : "MISMATCH", unhashed);
+        }
+    }
 }
 
 
@@ -442,21 +855,6 @@ namespace Evaluation {
        a b c d e f g h       a b c d e f g h       a b c d e f g h        a b c d e f g h
 */
 
-// file masks [square]
-    U64 file_masks[64];
-
-    // rank masks [square]
-    U64 rank_masks[64];
-
-    // isolated pawn masks [square]
-    U64 isolated_masks[64];
-
-    // white passed pawn masks [square]
-    U64 white_passed_masks[64];
-
-    // black passed pawn masks [square]
-    U64 black_passed_masks[64];
-
     // extract rank from a square [square]
     const int get_rank[64] =
     {
@@ -489,7 +887,7 @@ namespace Evaluation {
     const int king_shield_bonus = 5;
 
     // set file or rank mask
-    U64 set_file_rank_mask(int file_number, int rank_number)
+    constexpr U64 set_file_rank_mask(int file_number, int rank_number)
     {
         // file or rank mask
         U64 mask = 0ULL;
@@ -525,9 +923,21 @@ namespace Evaluation {
         return mask;
     }
 
-    // init evaluation masks
-    void init_evaluation_masks()
+    // evaluation masks
+    typedef struct {
+        U64 file_masks[64];             // file masks [square]
+        U64 rank_masks[64];             // rank masks [square]
+        U64 isolated_masks[64];         // isolated pawn masks [square]
+        U64 white_passed_masks[64];     // white passed pawn masks [square]
+        U64 black_passed_masks[64];     // black passed pawn masks [square]
+    } EvaluationMasks;
+
+    // generate evaluation masks (at compile time)
+    constexpr EvaluationMasks generate_evaluation_masks()
     {
+        // evaluation masks
+        EvaluationMasks masks = {};
+
         /******** Init file masks ********/
 
         // loop over ranks
@@ -540,7 +950,7 @@ namespace Evaluation {
                 int square = rank * 8 + file;
 
                 // init file mask for a current square
-                file_masks[square] |= set_file_rank_mask(file, -1);
+                masks.file_masks[square] |= set_file_rank_mask(file, -1);
             }
         }
 
@@ -556,7 +966,7 @@ namespace Evaluation {
                 int square = rank * 8 + file;
 
                 // init rank mask for a current square
-                rank_masks[square] |= set_file_rank_mask(-1, rank);
+                masks.rank_masks[square] |= set_file_rank_mask(-1, rank);
             }
         }
 
@@ -572,8 +982,8 @@ namespace Evaluation {
                 int square = rank * 8 + file;
 
                 // init isolated pawns masks for a current square
-                isolated_masks[square] |= set_file_rank_mask(file - 1, -1);
-                isolated_masks[square] |= set_file_rank_mask(file + 1, -1);
+                masks.isolated_masks[square] |= set_file_rank_mask(file - 1, -1);
+                masks.isolated_masks[square] |= set_file_rank_mask(file + 1, -1);
             }
         }
 
@@ -589,14 +999,14 @@ namespace Evaluation {
                 int square = rank * 8 + file;
 
                 // init white passed pawns mask for a current square
-                white_passed_masks[square] |= set_file_rank_mask(file - 1, -1);
-                white_passed_masks[square] |= set_file_rank_mask(file, -1);
-                white_passed_masks[square] |= set_file_rank_mask(file + 1, -1);
+                masks.white_passed_masks[square] |= set_file_rank_mask(file - 1, -1);
+                masks.white_passed_masks[square] |= set_file_rank_mask(file, -1);
+                masks.white_passed_masks[square] |= set_file_rank_mask(file + 1, -1);
 
                 // loop over redudant ranks
                 for (int i = 0; i < (8 - rank); i++)
                     // reset redudant bits 
-                    white_passed_masks[square] &= ~rank_masks[(7 - i) * 8 + file];
+                    masks.white_passed_masks[square] &= ~masks.rank_masks[(7 - i) * 8 + file];
             }
         }
 
@@ -612,20 +1022,40 @@ namespace Evaluation {
                 int square = rank * 8 + file;
 
                 // init black passed pawns mask for a current square
-                black_passed_masks[square] |= set_file_rank_mask(file - 1, -1);
-                black_passed_masks[square] |= set_file_rank_mask(file, -1);
-                black_passed_masks[square] |= set_file_rank_mask(file + 1, -1);
+                masks.black_passed_masks[square] |= set_file_rank_mask(file - 1, -1);
+                masks.black_passed_masks[square] |= set_file_rank_mask(file, -1);
+                masks.black_passed_masks[square] |= set_file_rank_mask(file + 1, -1);
 
                 // loop over redudant ranks
                 for (int i = 0; i < rank + 1; i++)
                     // reset redudant bits 
-                    black_passed_masks[square] &= ~rank_masks[i * 8 + file];
+                    masks.black_passed_masks[square] &= ~masks.rank_masks[i * 8 + file];
             }
         }
+
+        return masks;
     }
 
+    // evaluation masks (read-only data)
+    constexpr EvaluationMasks evaluation_masks = generate_evaluation_masks();
+
+    // file masks [square]
+    constexpr const U64 (&file_masks)[64] = evaluation_masks.file_masks;
+
+    // rank masks [square]
+    constexpr const U64 (&rank_masks)[64] = evaluation_masks.rank_masks;
+
+    // isolated pawn masks [square]
+    constexpr const U64 (&isolated_masks)[64] = evaluation_masks.isolated_masks;
+
+    // white passed pawn masks [square]
+    constexpr const U64 (&white_passed_masks)[64] = evaluation_masks.white_passed_masks;
+
+    // black passed pawn masks [square]
+    constexpr const U64 (&black_passed_masks)[64] = evaluation_masks.black_passed_masks;
+
     // get game phase score
-    static inline int get_game_phase_score()
+    static inline int get_game_phase_score(const Position& pos)
     {
         /*
             The game phase score of the game is derived from the pieces
@@ -643,27 +1073,37 @@ namespace Evaluation {
 
         // loop over white pieces
         for (int piece = N; piece <= Q; piece++)
-            white_piece_scores += count_bits(bitboards[piece]) * material_score[opening][piece];
+            white_piece_scores += count_bits(pos.bitboards[piece]) * material_score[opening][piece];
 
         // loop over white pieces
         for (int piece = n; piece <= q; piece++)
-            black_piece_scores += count_bits(bitboards[piece]) * -material_score[opening][piece];
+            black_piece_scores += count_bits(pos.bitboards[piece]) * -material_score[opening][piece];
 
         // return game phase score
         return white_piece_scores + black_piece_scores;
     }
 
     // position evaluation
-    int evaluate()
+    int evaluate(const Position& pos)
     {
 
         // get game phase score
-        int game_phase_score = get_game_phase_score();
-        printf("game phase score: %d\n", game_phase_score);
+        int game_phase_score = get_game_phase_score(pos);
+
+        // game phase (opening, middle game, endgame)
+        int game_phase = -1;
+
+        // pick up game phase based on game phase score
+        if (game_phase_score > opening_phase_score) game_phase = opening;
+        else if (game_phase_score < endgame_phase_score) game_phase = endgame;
+        else game_phase = middlegame;
 
         // static evaluation score
         int score = 0;
 
+        // material & positional scores for opening and endgame
+        int score_opening = 0, score_endgame = 0;
+
         // current pieces bitboard copy
         U64 bitboard;
 
@@ -677,7 +1117,7 @@ namespace Evaluation {
         for (int bb_piece = P; bb_piece <= k; bb_piece++)
         {
             // init piece bitboard copy
-            bitboard = bitboards[bb_piece];
+            bitboard = pos.bitboards[bb_piece];
 
             // loop over pieces within a bitboard
             while (bitboard)
@@ -689,7 +1129,8 @@ namespace Evaluation {
                 square = get_ls1b_index(bitboard);
 
                 // score material weights
-                score += material_score[piece];
+                score_opening += material_score[opening][piece];
+                score_endgame += material_score[endgame][piece];
 
                 // score positional piece scores
                 switch (piece)
@@ -697,22 +1138,23 @@ namespace Evaluation {
                     // evaluate white pieces
                 case P: 
                     // positional score
-                    score += pawn_score[square];
+                    score_opening += positional_score[opening][PAWN][square];
+                    score_endgame += positional_score[endgame][PAWN][square];
 
                     // double pawn penalty
-                    double_pawns = count_bits(bitboards[P] & file_masks[square]);
+                    double_pawns = count_bits(pos.bitboards[P] & file_masks[square]);
 
                     // on double pawns (tripple, etc)
                     if (double_pawns > 1)
                         score += double_pawns * double_pawn_penalty;
 
                     // on isolated pawn
-                    if ((bitboards[P] & isolated_masks[square]) == 0)
+                    if ((pos.bitboards[P] & isolated_masks[square]) == 0)
                         // give an isolated pawn penalty
                         score += isolated_pawn_penalty;
 
                     // on passed pawn
-                    if ((white_passed_masks[square] & bitboards[p]) == 0)
+                    if ((white_passed_masks[square] & pos.bitboards[p]) == 0)
                         // give passed pawn bonus
                         score += passed_pawn_bonus[get_rank[square]];
 
@@ -720,29 +1162,32 @@ namespace Evaluation {
 
                 case N:
                     // positional score
-                    score += knight_score[square];
+                    score_opening += positional_score[opening][KNIGHT][square];
+                    score_endgame += positional_score[endgame][KNIGHT][square];
                     break;
 
                 case B: 
                     // positional scores
-                    score += bishop_score[square];
+                    score_opening += positional_score[opening][BISHOP][square];
+                    score_endgame += positional_score[endgame][BISHOP][square];
 
                     // mobility
-                    score += count_bits(Attacks::get_bishop_attacks(square, occupancies[both]));
+                    score += count_bits(Attacks::get_bishop_attacks(square, pos.occupancies[both]));
 
                     break;
 
                 case R: 
                     // positional score
-                    score += rook_score[square];
+                    score_opening += positional_score[opening][ROOK][square];
+                    score_endgame += positional_score[endgame][ROOK][square];
 
                     // semi open file
-                    if ((bitboards[P] & file_masks[square]) == 0)
+                    if ((pos.bitboards[P] & file_masks[square]) == 0)
                         // add semi open file bonus
                         score += semi_open_file_score;
 
                     // semi open file
-                    if (((bitboards[P] | bitboards[p]) & file_masks[square]) == 0)
+                    if (((pos.bitboards[P] | pos.bitboards[p]) & file_masks[square]) == 0)
                         // add semi open file bonus
                         score += open_file_score;
 
@@ -751,47 +1196,49 @@ namespace Evaluation {
                     // evaluate white queens
                 case Q:
                     // mobility
-                    score += count_bits(Attacks::get_queen_attacks(square, occupancies[both]));
+                    score += count_bits(Attacks::get_queen_attacks(square, pos.occupancies[both]));
                     break;
 
                 case K: 
                     // posirional score
-                    score += king_score[square];
+                    score_opening += positional_score[opening][KING][square];
+                    score_endgame += positional_score[endgame][KING][square];
 
                     // semi open file
-                    if ((bitboards[P] & file_masks[square]) == 0)
+                    if ((pos.bitboards[P] & file_masks[square]) == 0)
                         // add semi open file penalty
                         score -= semi_open_file_score;
 
                     // semi open file
-                    if (((bitboards[P] | bitboards[p]) & file_masks[square]) == 0)
+                    if (((pos.bitboards[P] | pos.bitboards[p]) & file_masks[square]) == 0)
                         // add semi open file penalty
                         score -= open_file_score;
 
                     // king safety bonus
-                    score += count_bits(Attacks::king_attacks[square] & occupancies[white]) * king_shield_bonus;
+                    score += count_bits(Attacks::king_attacks[square] & pos.occupancies[white]) * king_shield_bonus;
                     break;
 
 
                     // evaluate black pawns
                 case p:
                     // positional score
-                    score -= pawn_score[mirror_score[square]];
+                    score_opening -= positional_score[opening][PAWN][mirror_score[square]];
+                    score_endgame -= positional_score[endgame][PAWN][mirror_score[square]];
 
                     // double pawn penalty
-                    double_pawns = count_bits(bitboards[p] & file_masks[square]);
+                    double_pawns = count_bits(pos.bitboards[p] & file_masks[square]);
 
                     // on double pawns (tripple, etc)
                     if (double_pawns > 1)
                         score -= double_pawns * double_pawn_penalty;
 
                     // on isolated pawnd
-                    if ((bitboards[p] & isolated_masks[square]) == 0)
+                    if ((pos.bitboards[p] & isolated_masks[square]) == 0)
                         // give an isolated pawn penalty
                         score -= isolated_pawn_penalty;
 
                     // on passed pawn
-                    if ((black_passed_masks[square] & bitboards[P]) == 0)
+                    if ((black_passed_masks[square] & pos.bitboards[P]) == 0)
                         // give passed pawn bonus
                         score -= passed_pawn_bonus[get_rank[mirror_score[square]]];
 
@@ -800,30 +1247,33 @@ namespace Evaluation {
                     // evaluate black knights
                 case n:
                     // positional score
-                    score -= knight_score[mirror_score[square]];
+                    score_opening -= positional_score[opening][KNIGHT][mirror_score[square]];
+                    score_endgame -= positional_score[endgame][KNIGHT][mirror_score[square]];
                     break;
 
                     // evaluate black bishops
                 case b:
                     // positional score
-                    score -= bishop_score[mirror_score[square]];
+                    score_opening -= positional_score[opening][BISHOP][mirror_score[square]];
+                    score_endgame -= positional_score[endgame][BISHOP][mirror_score[square]];
 
                     // mobility
-                    score -= count_bits(Attacks::get_bishop_attacks(square, occupancies[both]));
+                    score -= count_bits(Attacks::get_bishop_attacks(square, pos.occupancies[both]));
                     break;
 
                     // evaluate black rooks
                 case r:
                     // positional score
-                    score -= rook_score[mirror_score[square]];
+                    score_opening -= positional_score[opening][ROOK][mirror_score[square]];
+                    score_endgame -= positional_score[endgame][ROOK][mirror_score[square]];
 
                     // semi open file
-                    if ((bitboards[p] & file_masks[square]) == 0)
+                    if ((pos.bitboards[p] & file_masks[square]) == 0)
                         // add semi open file bonus
                         score -= semi_open_file_score;
 
                     // semi open file
-                    if (((bitboards[P] | bitboards[p]) & file_masks[square]) == 0)
+                    if (((pos.bitboards[P] | pos.bitboards[p]) & file_masks[square]) == 0)
                         // add semi open file bonus
                         score -= open_file_score;
 
@@ -832,26 +1282,27 @@ namespace Evaluation {
                     // evaluate black queens
                 case q:
                     // mobility
-                    score -= count_bits(Attacks::get_queen_attacks(square, occupancies[both]));
+                    score -= count_bits(Attacks::get_queen_attacks(square, pos.occupancies[both]));
                     break;
 
                     // evaluate black king
                 case k:
                     // positional score
-                    score -= king_score[mirror_score[square]];
+                    score_opening -= positional_score[opening][KING][mirror_score[square]];
+                    score_endgame -= positional_score[endgame][KING][mirror_score[square]];
 
                     // semi open file
-                    if ((bitboards[p] & file_masks[square]) == 0)
+                    if ((pos.bitboards[p] & file_masks[square]) == 0)
                         // add semi open file penalty
                         score += semi_open_file_score;
 
                     // semi open file
-                    if (((bitboards[P] | bitboards[p]) & file_masks[square]) == 0)
+                    if (((pos.bitboards[P] | pos.bitboards[p]) & file_masks[square]) == 0)
                         // add semi open file penalty
                         score += open_file_score;
 
                     // king safety bonus
-                    score -= count_bits(Attacks::king_attacks[square] & occupancies[black]) * king_shield_bonus;
+                    score -= count_bits(Attacks::king_attacks[square] & pos.occupancies[black]) * king_shield_bonus;
                     break;
                 }
                 
@@ -861,8 +1312,32 @@ namespace Evaluation {
             }
         }
 
+        /*
+            Now in order to calculate interpolated score
+            for a given game phase we use this formula
+            (same for material and positional scores):
+
+            (
+              score_opening * game_phase_score +
+              score_endgame * (opening_phase_score - game_phase_score)
+            ) / opening_phase_score
+        */
+
+        // interpolate score in the middle game
+        if (game_phase == middlegame)
+            score += (
+                score_opening * game_phase_score +
+                score_endgame * (opening_phase_score - game_phase_score)
+                ) / opening_phase_score;
+
+        // return pure opening score in opening
+        else if (game_phase == opening) score += score_opening;
+
+        // return pure endgame score in endgame
+        else if (game_phase == endgame) score += score_endgame;
+
         // return final evaluation based on side
-        return (side == white) ? score : -score;
+        return (pos.side == white) ? score : -score;
     }
 
 }
@@ -876,8 +1351,15 @@ namespace Search {
 #define infinity 50000
 #define mate_value 49000
 #define mate_score 48000
-   // hash table size
-#define hash_size 0x400000
+   // hash table size in MB (default & max, UCI "Hash" option)
+#define default_hash_mb 64
+#define max_hash_mb 65536
+
+// transposition table entries per bucket
+#define bucket_entries 5
+
+// large (huge) page size on x64
+#define large_page_size 0x200000
 
 // no hash entry found constant
 #define no_hash_entry 100000
@@ -887,94 +1369,418 @@ namespace Search {
 #define hash_flag_alpha 1
 #define hash_flag_beta 2
 
-// transposition table data structure
+// transposition table data structure (12 bytes)
     typedef struct {
-        U64 hash_key;   // "almost" unique chess position identifier
-        int depth;      // current search depth
-        int flag;       // flag the type of node (fail-low/fail-high/PV) 
-        int score;      // score (alpha/beta/PV)
+        unsigned int key;           // lower 32 bits of hash key (upper bits pick the bucket)
+        int score;                  // score (alpha/beta/PV)
+        U16 best_move;              // best move found in the position (hash move, compact)
+        unsigned char depth;        // current search depth (0 on empty entries)
+        unsigned char flag_age;     // flag the type of node (fail-low/fail-high/PV) in bits 0-1, search age in bits 2-7
     } transpositionTable;               // transposition table (TT aka hash table)
 
-// define TT instance
-    transpositionTable hash_table[hash_size];
+// transposition table bucket (one cache line, probing the position takes a single cache miss)
+    typedef struct alignas(64) {
+        transpositionTable entries[bucket_entries];
+    } hashBucket;
 
-    // clear TT (hash table)
-    void clear_hash_table()
+// define TT instance (allocated at run time, see init_hash_table)
+    hashBucket* hash_table = NULL;
+
+    // TT memory kinds (how the memory block was allocated)
+    enum { normal_pages, large_pages, transparent_huge_pages };
+
+    // TT memory kind names (reported on allocation, kernel may still back advised memory with normal pages)
+    const char* page_kind_names[] = { "normal pages", "large pages", "requested transparent huge pages" };
+
+    // allocated memory block (TT is aligned to cache line within it), its size & kind, number of buckets & size in MB
+    void* hash_memory = NULL;
+    size_t hash_memory_size = 0;
+    int hash_memory_kind = normal_pages;
+    U64 hash_bucket_count = 0;
+    int hash_megabytes = default_hash_mb;
+
+    // try large pages for TT first (fewer TLB misses on random TT probes), bench switches it off to compare
+    int use_large_pages = 1;
+
+    // search age (increments with every search, older entries are replaced first)
+    int hash_age = 0;
+
+    // TT statistics: probes & hits since the start of current search
+    long hash_probes = 0, hash_hits = 0;
+
+    // get TT bucket of the position (multiply-shift of upper hash key bits instead of 64-bit modulo)
+    static inline hashBucket* get_hash_bucket(U64 hash_key)
     {
-        // loop over TT elements
-        for (int index = 0; index < hash_size; index++)
-        {
-            // reset TT inner fields
-            hash_table[index].hash_key = 0;
-            hash_table[index].depth = 0;
-            hash_table[index].flag = 0;
-            hash_table[index].score = 0;
-        }
+        return &hash_table[((hash_key >> 32) * hash_bucket_count) >> 32];
     }
 
-    // read hash entry data
-    static inline int read_hash_entry(int alpha, int beta, int depth)
+#ifdef _WIN32
+    // allocate memory in large pages (needs "Lock pages in memory" user right, NULL if not granted)
+    static void* allocate_windows_large_pages(size_t size)
     {
-        // create a TT instance pointer to particular hash entry storing
-        // the scoring data for the current board position if available
-        transpositionTable* hash_entry = &hash_table[hash_key % hash_size];
+        // large pages are not supported
+        SIZE_T page_size = GetLargePageMinimum();
 
-        // make sure we're dealing with the exact position we need
-        if (hash_entry->hash_key == hash_key)
-        {
-            // make sure that we match the exact depth our search is now at
-            if (hash_entry->depth >= depth)
-            {
-                // extract stored score from TT entry
-                int score = hash_entry->score;
+        if (page_size == 0)
+            return NULL;
 
-                // retrieve score independent from the actual path
-                // from root node (position) to current node (position)
-                if (score < -mate_score) score += ply;
-                if (score > mate_score) score -= ply;
+        // enable SeLockMemoryPrivilege for the process
+        HANDLE token;
 
-                // match the exact (PV node) score 
-                if (hash_entry->flag == hash_flag_exact)
-                    // return exact (PV node) score
-                    return score;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+            return NULL;
 
+        void* memory = NULL;
+        TOKEN_PRIVILEGES privileges;
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
 
+        // AdjustTokenPrivileges succeeds without the right too, so check the last error
+        if (LookupPrivilegeValue(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+            AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL) && GetLastError() == ERROR_SUCCESS)
+            // allocate whole large pages (zero filled)
+            memory = VirtualAlloc(NULL, (size + page_size - 1) & ~(page_size - 1), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
 
-                // match alpha (fail-low node) score
-                if ((hash_entry->flag == hash_flag_alpha) &&
-                    (hash_entry->score <= alpha))
-                    // return alpha (fail-low node) score
-                    return alpha;
+        CloseHandle(token);
 
-                // match beta (fail-high node) score
-                if ((hash_entry->flag == hash_flag_beta) &&
-                    (hash_entry->score >= beta))
-                    // return beta (fail-high node) score
-                    return beta;
-            }
-        }
+        return memory;
+    }
+#endif
 
-        // if hash entry doesn't exist
-        return no_hash_entry;
+#ifdef __linux__
+    // check if transparent huge pages mode honours madvise ("always" or "madvise", not "never" or no THP support)
+    static int transparent_huge_pages_enabled()
+    {
+        std::ifstream mode("/sys/kernel/mm/transparent_hugepage/enabled");
+        std::string line;
+
+        return std::getline(mode, line) && line.find("[never]") == std::string::npos;
     }
 
-    // write hash entry data
-    static inline void write_hash_entry(int score, int depth, int hash_flag)
+    // get size of anonymous memory backed by huge pages in the process in KB (-1 if unknown)
+    long anon_huge_pages_kb()
     {
-        // create a TT instance pointer to particular hash entry storing
-        // the scoring data for the current board position if available
-        transpositionTable* hash_entry = &hash_table[hash_key % hash_size];
+        std::ifstream rollup("/proc/self/smaps_rollup");
+        std::string line;
 
-        // store score independent from the actual path
-        // from root node (position) to current node (position)
-        if (score < -mate_score) score -= ply;
-        if (score > mate_score) score += ply;
+        while (std::getline(rollup, line))
+            if (line.compare(0, 14, "AnonHugePages:") == 0)
+                return atol(line.c_str() + 14);
 
-        // write hash entry data 
-        hash_entry->hash_key = hash_key;
-        hash_entry->score = score;
-        hash_entry->flag = hash_flag;
-        hash_entry->depth = depth;
+        return -1;
+    }
+#else
+    // huge pages usage is not reported on this platform
+    long anon_huge_pages_kb()
+    {
+        return -1;
+    }
+#endif
+
+    // allocate zero filled TT memory, large pages are tried first (falls back to calloc, NULL if out of memory)
+    //   Windows: VirtualAlloc with MEM_LARGE_PAGES
+    //   Linux: reserved huge pages (vm.nr_hugepages) or transparent huge pages on 2 MB aligned memory (madvise)
+    static void* allocate_hash_memory(size_t size, int& kind)
+    {
+        kind = normal_pages;
+
+#ifdef _WIN32
+        if (use_large_pages)
+        {
+            // large pages
+            void* memory = allocate_windows_large_pages(size);
+
+            if (memory)
+            {
+                kind = large_pages;
+                return memory;
+            }
+        }
+#elif defined(__linux__)
+        if (use_large_pages)
+        {
+            // size in whole huge pages
+            size_t rounded = (size + large_page_size - 1) & ~(size_t)(large_page_size - 1);
+
+            // reserved huge pages
+            void* memory = mmap(NULL, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+            if (memory != MAP_FAILED)
+            {
+                kind = large_pages;
+                return memory;
+            }
+
+            // map a spare huge page, so the block can be aligned to huge page (unless THP is off)
+            memory = transparent_huge_pages_enabled() ?
+                mmap(NULL, rounded + large_page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : MAP_FAILED;
+
+            if (memory != MAP_FAILED)
+            {
+                // unmap unaligned head & tail (spare page is split between them)
+                char* aligned = (char*)(((uintptr_t)memory + large_page_size - 1) & ~(uintptr_t)(large_page_size - 1));
+                size_t head = aligned - (char*)memory;
+                size_t tail = large_page_size - head;
+
+                if (head) munmap(memory, head);
+                if (tail) munmap(aligned + rounded, tail);
+
+                // ask kernel to back the block with huge pages
+                if (madvise(aligned, rounded, MADV_HUGEPAGE) == 0)
+                {
+                    kind = transparent_huge_pages;
+                    return aligned;
+                }
+
+                // transparent huge pages are not supported
+                munmap(aligned, rounded);
+            }
+        }
+#endif
+
+        // normal pages (mapped on the first touch)
+        return calloc(size, 1);
+    }
+
+    // free TT memory allocated by allocate_hash_memory
+    static void free_hash_memory(void* memory, size_t size, int kind)
+    {
+        if (memory == NULL)
+            return;
+
+        if (kind == normal_pages)
+            free(memory);
+
+#ifdef _WIN32
+        else
+            VirtualFree(memory, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        else
+            munmap(memory, (size + large_page_size - 1) & ~(size_t)(large_page_size - 1));
+#endif
+    }
+
+    // (re)allocate TT of given size in MB (zero filled, previous table is kept if allocation fails)
+    void init_hash_table(int megabytes)
+    {
+        // clamp TT size
+        if (megabytes < 1) megabytes = 1;
+        if (megabytes > max_hash_mb) megabytes = max_hash_mb;
+
+        // number of buckets
+        U64 buckets = (U64)megabytes * 0x100000 / sizeof(hashBucket);
+
+        // allocate zero filled memory, with a spare cache line for alignment
+        size_t size = (size_t)(buckets * sizeof(hashBucket) + 63);
+        int kind;
+        void* memory = allocate_hash_memory(size, kind);
+
+        if (memory == NULL)
+        {
+            printf("info string hash: can't allocate %d MB, keeping %d MB\n", megabytes, hash_megabytes);
+            return;
+        }
+
+        // free previous table
+        free_hash_memory(hash_memory, hash_memory_size, hash_memory_kind);
+
+        // align TT to cache line
+        hash_memory = memory;
+        hash_memory_size = size;
+        hash_memory_kind = kind;
+        hash_table = (hashBucket*)(((uintptr_t)memory + 63) & ~(uintptr_t)63);
+        hash_bucket_count = buckets;
+        hash_megabytes = megabytes;
+
+        // reset search age
+        hash_age = 0;
+
+        // report TT size & the way it's allocated
+        printf("info string hash: %d MB, %s\n", megabytes, page_kind_names[kind]);
+    }
+
+    // clear a range of TT buckets (one thread's share of clearing)
+    static void clear_hash_range(U64 start, U64 count)
+    {
+        memset(hash_table + start, 0, (size_t)(count * sizeof(hashBucket)));
+    }
+
+    // clear TT (hash table), large tables are cleared on all hardware threads
+    void clear_hash_table()
+    {
+        // reset search age
+        hash_age = 0;
+
+        // TT is not allocated yet
+        if (hash_table == NULL)
+            return;
+
+        // one thread per 64 MB, up to the number of hardware threads
+        int threads = (int)std::thread::hardware_concurrency();
+        if (threads > 64) threads = 64;
+        if ((U64)threads > hash_bucket_count / 0x100000 + 1) threads = (int)(hash_bucket_count / 0x100000 + 1);
+        if (threads < 1) threads = 1;
+
+        // start helper threads, current thread clears the first range
+        std::thread helpers[64];
+
+        for (int thread = 1; thread < threads; thread++)
+        {
+            U64 start = hash_bucket_count * thread / threads;
+            helpers[thread] = std::thread(clear_hash_range, start, hash_bucket_count * (thread + 1) / threads - start);
+        }
+
+        clear_hash_range(0, hash_bucket_count / threads);
+
+        // wait for helper threads
+        for (int thread = 1; thread < threads; thread++)
+            helpers[thread].join();
+    }
+
+    // start a new search: age TT entries & reset TT statistics
+    void new_hash_search()
+    {
+        hash_age = (hash_age + 1) & 63;
+        hash_probes = 0;
+        hash_hits = 0;
+    }
+
+    // TT usage in permill (entries of current search within the first 1000 entries)
+    int hash_full()
+    {
+        int used = 0;
+
+        for (int index = 0; index < 1000 / bucket_entries; index++)
+            for (int entry = 0; entry < bucket_entries; entry++)
+                used += hash_table[index].entries[entry].depth && (hash_table[index].entries[entry].flag_age >> 2) == hash_age;
+
+        return used * 1000 / (1000 / bucket_entries * bucket_entries);
+    }
+
+    // read hash entry data
+    static inline int read_hash_entry(const Position& pos, int alpha, int beta, int* best_move, int depth)
+    {
+        // bucket of the position & key to match
+        hashBucket* bucket = get_hash_bucket(pos.hash_key);
+        unsigned int key = (unsigned int)pos.hash_key;
+
+        hash_probes++;
+
+        // loop over bucket entries
+        for (int index = 0; index < bucket_entries; index++)
+        {
+            transpositionTable* hash_entry = &bucket->entries[index];
+
+            // make sure we're dealing with the exact position we need
+            if (hash_entry->key != key || hash_entry->depth == 0)
+                continue;
+
+            hash_hits++;
+
+            // entry is still in use, refresh its age
+            hash_entry->flag_age = (unsigned char)((hash_entry->flag_age & 3) | (hash_age << 2));
+
+            // store hash move regardless of the depth it was searched to
+            *best_move = MoveGeneration::expand_move(pos, hash_entry->best_move);
+
+            // make sure that we match the exact depth our search is now at
+            if (hash_entry->depth >= depth)
+            {
+                // extract stored score & flag from TT entry
+                int score = hash_entry->score;
+                int flag = hash_entry->flag_age & 3;
+
+                // retrieve score independent from the actual path
+                // from root node (position) to current node (position)
+                if (score < -mate_score) score += pos.ply;
+                if (score > mate_score) score -= pos.ply;
+
+                // match the exact (PV node) score 
+                if (flag == hash_flag_exact)
+                    // return exact (PV node) score
+                    return score;
+
+                // match alpha (fail-low node) score
+                if ((flag == hash_flag_alpha) &&
+                    (hash_entry->score <= alpha))
+                    // return alpha (fail-low node) score
+                    return alpha;
+
+                // match beta (fail-high node) score
+                if ((flag == hash_flag_beta) &&
+                    (hash_entry->score >= beta))
+                    // return beta (fail-high node) score
+                    return beta;
+            }
+
+            break;
+        }
+
+        // if hash entry doesn't exist
+        return no_hash_entry;
+    }
+
+    // write hash entry data
+    static inline void write_hash_entry(const Position& pos, int score, int best_move, int depth, int hash_flag)
+    {
+        // bucket of the position & key to store
+        hashBucket* bucket = get_hash_bucket(pos.hash_key);
+        unsigned int key = (unsigned int)pos.hash_key;
+
+        // compact best move to store
+        U16 move = compact_move(best_move);
+
+        // entry to replace
+        transpositionTable* hash_entry = &bucket->entries[0];
+        int replace_score = 0x7fffffff;
+
+        // loop over bucket entries
+        for (int index = 0; index < bucket_entries; index++)
+        {
+            transpositionTable* entry = &bucket->entries[index];
+
+            // same position: update its entry
+            if (entry->key == key && entry->depth)
+            {
+                // keep deeper result of the position unless the new one is exact
+                if (hash_flag != hash_flag_exact && depth < entry->depth - 2 && ((entry->flag_age >> 2) == hash_age))
+                {
+                    // still remember the best move
+                    if (move)
+                        entry->best_move = move;
+
+                    return;
+                }
+
+                // keep old hash move if there's no new one
+                if (move == 0)
+                    move = entry->best_move;
+
+                hash_entry = entry;
+                break;
+            }
+
+            // otherwise replace the shallowest entry, entries of older searches first
+            int entry_score = entry->depth - 8 * ((hash_age - (entry->flag_age >> 2)) & 63);
+
+            if (entry_score < replace_score)
+            {
+                replace_score = entry_score;
+                hash_entry = entry;
+            }
+        }
+
+        // store score independent from the actual path
+        // from root node (position) to current node (position)
+        if (score < -mate_score) score -= pos.ply;
+        if (score > mate_score) score += pos.ply;
+
+        // write hash entry data 
+        hash_entry->key = key;
+        hash_entry->score = score;
+        hash_entry->best_move = move;
+        hash_entry->flag_age = (unsigned char)(hash_flag | (hash_age << 2));
+        hash_entry->depth = (unsigned char)depth;
     }
 
 
@@ -1010,11 +1816,112 @@ namespace Search {
         100, 200, 300, 400, 500, 600,  100, 200, 300, 400, 500, 600
     };
 
+    // piece values used by static exchange evaluation [piece]
+    const int see_values[12] = { 100, 300, 300, 500, 900, 20000, 100, 300, 300, 500, 900, 20000 };
+
+    // static exchange evaluation: material balance of the capture sequence on the target square of a move
+    // (both sides recapture with the least valuable attacker, x-ray attackers join the exchange)
+    int see(const Position& pos, int move)
+    {
+        // parse move
+        int source_square = get_move_source(move);
+        int target_square = get_move_target(move);
+        int promoted_piece = get_move_promoted(move);
+
+        // castling never loses material
+        if (get_move_castling(move))
+            return 0;
+
+        // material gains of the capture sequence [exchange depth]
+        int gain[32];
+        int depth = 0;
+
+        // occupancy after the move
+        U64 occupancy = pos.occupancies[both] ^ (1ULL << source_square);
+
+        // first capture (enpassant captured pawn is not on the target square)
+        if (get_move_enpassant(move))
+        {
+            occupancy ^= 1ULL << (target_square + ((pos.side == white) ? 8 : -8));
+            gain[0] = see_values[P];
+        }
+
+        else
+            gain[0] = (pos.piece_on[target_square] == no_piece) ? 0 : see_values[pos.piece_on[target_square]];
+
+        // piece standing on the target square after the move
+        int piece = get_move_piece(move);
+
+        if (promoted_piece)
+        {
+            gain[0] += see_values[promoted_piece] - see_values[P];
+            piece = promoted_piece;
+        }
+
+        // sliders of both sides that may join the exchange through x-rays
+        U64 diagonal_sliders = pos.bitboards[B] | pos.bitboards[b] | pos.bitboards[Q] | pos.bitboards[q];
+        U64 straight_sliders = pos.bitboards[R] | pos.bitboards[r] | pos.bitboards[Q] | pos.bitboards[q];
+
+        // pieces attacking the target square
+        U64 attackers = MoveGeneration::attackers_to(pos, target_square, occupancy) & occupancy;
+
+        // side to recapture
+        int side = pos.side ^ 1;
+
+        // loop over recaptures
+        while (true)
+        {
+            // attackers of the side to recapture
+            U64 side_attackers = attackers & pos.occupancies[side];
+
+            // no more recaptures
+            if (!side_attackers)
+                break;
+
+            // find least valuable attacker
+            int attacker = (side == white) ? P : p;
+            U64 attacker_bitboard = 0ULL;
+
+            for (; attacker <= ((side == white) ? K : k); attacker++)
+                if ((attacker_bitboard = side_attackers & pos.bitboards[attacker]))
+                    break;
+
+            // king can't recapture on a square still defended by the opponent
+            if ((attacker == K || attacker == k) && (attackers & pos.occupancies[side ^ 1]))
+                break;
+
+            // gain of the recapture (captured piece value minus the gain so far)
+            depth++;
+            gain[depth] = see_values[piece] - gain[depth - 1];
+
+            // remove the attacker from the occupancy
+            occupancy ^= attacker_bitboard & ~(attacker_bitboard - 1);
+
+            // add x-ray attackers hidden behind it
+            attackers |= Attacks::get_bishop_attacks(target_square, occupancy) & diagonal_sliders;
+            attackers |= Attacks::get_rook_attacks(target_square, occupancy) & straight_sliders;
+            attackers &= occupancy;
+
+            // the attacker is now on the target square
+            piece = attacker;
+            side ^= 1;
+        }
+
+        // negamax the gains back to the first capture
+        while (depth)
+        {
+            gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+            depth--;
+        }
+
+        return gain[0];
+    }
+
     // max ply that we can reach within a search
     #define MAX_PLY 64
 
-    // killer moves [id][ply]
-    int killer_moves[2][MAX_PLY];
+    // killer moves [id][ply] (compact)
+    U16 killer_moves[2][MAX_PLY];
 
     // history moves [piece][square]
     int history_moves[12][64];
@@ -1043,89 +1950,39 @@ namespace Search {
     // PV length
     int pv_length[MAX_PLY];
 
-    // PV table
-    int pv_table[MAX_PLY][MAX_PLY];
-
-    // follow PV & score PV move
-    bool follow_pv, score_pv;
-
-
-    // enable PV move scoring
-    void enable_pv_scoring(std::vector<int>& move_list)
-    {
-        // disable following PV
-        follow_pv = false;
+    // PV table (compact moves)
+    U16 pv_table[MAX_PLY][MAX_PLY];
 
-        // loop over the moves within a move list
-        for (int count = 0; count < move_list.size(); count++)
-        {
-            // make sure we hit PV move
-            if (pv_table[0][ply] == move_list[count])
-            {
-                // enable move scoring
-                score_pv = true;
+    // follow PV
+    bool follow_pv;
 
-                // enable following PV
-                follow_pv = true;
-            }
-        }
-    }
+    // quiescence search nodes counter (included in the nodes count)
+    long quiescence_nodes;
 
     // score moves
-    int score_move(int move)
+    int score_move(const Position& pos, int move)
     {
-        // if PV move scoring is allowed
-        if (score_pv)
+        // score capture move (or queen promotion)
+        if (get_move_tactical(move))
         {
-            // make sure we are dealing with PV move
-            if (pv_table[0][ply] == move)
-            {
-                // disable score PV flag
-                score_pv = 0;
-
-                // give PV move the highest score to search it first
-                return 20000;
-            }
-        }
-
-        // score capture move
-        if (get_move_capture(move))
-        {
-            // init target piece
-            int target_piece = P;
-
-            // pick up bitboard piece index ranges depending on side
-            int start_piece, end_piece;
-
-            // pick up side to move
-            if (side == white) { start_piece = p; end_piece = k; }
-            else { start_piece = P; end_piece = K; }
+            // init target piece (pawn on enpassant captures & queen promotions)
+            int target_piece = pos.piece_on[get_move_target(move)];
+            if (target_piece == no_piece) target_piece = P;
 
-            // loop over bitboards opposite to the current side to move
-            for (int bb_piece = start_piece; bb_piece <= end_piece; bb_piece++)
-            {
-                // if there's a piece on the target square
-                if (get_bit(bitboards[bb_piece], get_move_target(move)))
-                {
-                    // remove it from corresponding bitboard
-                    target_piece = bb_piece;
-                    break;
-                }
-            }
-
-            // score move by MVV LVA lookup [source piece][target piece]
-            return mvv_lva[get_move_piece(move)][target_piece];
+            // score move by static exchange evaluation (losing captures score below 0),
+            // MVV LVA lookup [source piece][target piece] breaks the ties
+            return see(pos, move) * 1000 + mvv_lva[get_move_piece(move)][target_piece];
         }
 
         // score quiet move
         else
         {
             // score 1st killer move
-            if (killer_moves[0][ply] == move)
+            if (killer_moves[0][pos.ply] == compact_move(move))
                 return 9000;
 
             // score 2nd killer move
-            else if (killer_moves[1][ply] == move)
+            else if (killer_moves[1][pos.ply] == compact_move(move))
                 return 8000;
 
             // score history move
@@ -1137,145 +1994,330 @@ namespace Search {
         return 0;
     }
 
-    // sort moves in descending order
-    void sort_moves(std::vector<int>& move_list)
-    {
-       
-        // move scores
-        std::vector<int> move_scores;
-
-        // score all the moves within a move list
-        for (int count = 0; count < move_list.size(); count++)
-            // score move
-            move_scores.push_back(score_move(move_list[count]));
+    // move picker stages
+    enum { hash_stage, init_captures_stage, captures_stage, killers_stage, init_quiets_stage, quiets_stage, bad_captures_stage, done_stage };
 
-        // loop over current move within a move list
-        for (int current_move = 0; current_move < move_list.size(); current_move++)
-        {
-            // loop over next move within a move list
-            for (int next_move = current_move + 1; next_move < move_list.size(); next_move++)
-            {
-                // compare current and next move scores
-                if (move_scores[current_move] < move_scores[next_move])
-                {
-                    // swap scores
-                    int temp_score = move_scores[current_move];
-                    move_scores[current_move] = move_scores[next_move];
-                    move_scores[next_move] = temp_score;
-
-                    // swap moves
-                    int temp_move = move_list[current_move];
-                    move_list[current_move] = move_list[next_move];
-                    move_list[next_move] = temp_move;
-                }
-            }
-        }
+    // staged move picker
+    typedef struct {
+        MoveGeneration::MoveList captures;  // capture moves (generated lazily)
+        MoveGeneration::MoveList quiets;    // quiet moves (generated lazily)
+        int capture_scores[256];            // capture move scores
+        int quiet_scores[256];              // quiet move scores
+        int stage;                          // current stage
+        int index;                          // index of the next move within current stage
+        int hash_move;                      // hash (or PV) move
+        int only_captures;                  // pick up captures only (quiescence search)
+        int killers[2];                     // killer moves already picked up (taken out of quiet moves)
+        int bad_captures;                   // index of the first losing capture (searched after quiet moves)
+        MoveGeneration::CheckInfo check_info; // check & pin information for legal generation
+    } MovePicker;
+
+    // init move picker
+    void init_picker(MovePicker& picker, int hash_move, int only_captures, const MoveGeneration::CheckInfo& check_info)
+    {
+        picker.stage = hash_stage;
+        picker.index = 0;
+        picker.hash_move = hash_move;
+        picker.only_captures = only_captures;
+        picker.killers[0] = 0;
+        picker.killers[1] = 0;
+        picker.bad_captures = 0;
+        picker.check_info = check_info;
     }
 
-    // print move scores
-    void print_move_scores(std::vector<int>& move_list)
+    // remove move from a move list if it's there (returns 1 if the move has been found)
+    static inline int remove_move(MoveGeneration::MoveList& move_list, int move)
     {
-        printf("     Move scores:\n\n");
-
         // loop over moves within a move list
-        for (int count = 0; count < move_list.size(); count++)
+        for (int count = 0; count < move_list.count; count++)
         {
-            printf("     move: ");
-            MoveGeneration::print_move(move_list[count]);
-            printf(" score: %d\n", score_move(move_list[count]));
-        }
-    }
-
-    // position repetition detection
-    static int is_repetition()
-    {
-        // loop over repetition indicies range
-        for (int index = 0; index < repetition_index; index++)
-            // if we found the hash key same with a current
-            if (repetition_table[index] == hash_key)
-                // we found a repetition
+            // found the move
+            if (move_list.moves[count] == move)
+            {
+                // replace it with the last move in the list
+                move_list.moves[count] = move_list.moves[--move_list.count];
                 return 1;
+            }
+        }
 
-        // if no repetition found
+        // move is not in the list
         return 0;
     }
 
-    // quiescence search
-    static int quiescence(int alpha, int beta)
+    // pick the best scored move left in a move list (one step of selection sort)
+    static inline int pick_best(MoveGeneration::MoveList& move_list, int* scores, int index)
     {
-        // every 2047 nodes
-        if ((Perft::nodes & 2047) == 0)
-            // "listen" to the GUI/user input
-            Time::communicate();
+        // init best move index
+        int best = index;
 
-        // increment nodes count
-        Perft::nodes++;
+        // find the best scored move left in the list
+        for (int count = index + 1; count < move_list.count; count++)
+            if (scores[count] > scores[best])
+                best = count;
 
-        // we are too deep, hence there's an overflow of arrays relying on max ply constant
-        if (ply > MAX_PLY - 1)
-            // evaluate position
-            return Evaluation::evaluate();
+        // swap it with the move at current index
+        int temp_score = scores[index];
+        scores[index] = scores[best];
+        scores[best] = temp_score;
 
-        // evaluate position
-        int evaluation = Evaluation::evaluate();
+        int temp_move = move_list.moves[index];
+        move_list.moves[index] = move_list.moves[best];
+        move_list.moves[best] = temp_move;
 
-        // fail-hard beta cutoff
-        if (evaluation >= beta)
-        {
-            // node (position) fails high
-            return beta;
-        }
+        // return best move
+        return move_list.moves[index];
+    }
 
-        // found a better move
-        if (evaluation > alpha)
+    // get next move to search (returns 0 when there are no more moves)
+    int next_move(const Position& pos, MovePicker& picker)
+    {
+        switch (picker.stage)
         {
-            // PV node (position)
-            alpha = evaluation;
-        }
+        case hash_stage:
+            picker.stage = init_captures_stage;
 
-        // create move list instance
-        std::vector<int> move_list;
+            // no hash move or it can't be searched in quiescence
+            if (picker.hash_move == 0 || (picker.only_captures && !get_move_tactical(picker.hash_move)))
+            {
+                picker.hash_move = 0;
+                return next_move(pos, picker);
+            }
 
-        // generate moves
-        MoveGeneration::generate_moves(move_list);
+            // hash move may come from another position (index collision) so validate it
+            // instead of generating the moves to look it up
+            if (MoveGeneration::is_pseudo_legal(pos, picker.hash_move) && MoveGeneration::is_legal(pos, picker.check_info, picker.hash_move))
+                return picker.hash_move;
 
-        // sort moves
-        Search::sort_moves(move_list);
+            // hash move is not available in current position
+            picker.hash_move = 0;
+            return next_move(pos, picker);
 
-        // loop over moves within a movelist
-        for (int count = 0; count < move_list.size(); count++)
-        {
-            // preserve board state
-            copy_board();
+        case init_captures_stage:
+            // generate captures, take out hash move so it won't be picked for the second time
+            MoveGeneration::generate_captures(pos, picker.captures, picker.check_info);
 
-            // increment ply
-            ply++;
+            if (picker.hash_move && get_move_tactical(picker.hash_move))
+                remove_move(picker.captures, picker.hash_move);
 
-            // increment repetition index & store hash key
-            repetition_index++;
-            repetition_table[repetition_index] = hash_key;
+            // score captures by SEE & MVV LVA
+            for (int count = 0; count < picker.captures.count; count++)
+                picker.capture_scores[count] = score_move(pos, picker.captures.moves[count]);
 
-            // make sure to make only legal moves
-            if (MoveGeneration::make_move(move_list[count], MoveGeneration::only_captures) == 0)
-            {
-                // decrement ply
-                ply--;
+            picker.index = 0;
+            picker.stage = captures_stage;
 
-                // decrement repetition index
-                repetition_index--;
+            // fall through
 
-                // skip to next move
-                continue;
+        case captures_stage:
+            // pick up the best capture left unless it loses material
+            if (picker.index < picker.captures.count)
+            {
+                int move = pick_best(picker.captures, picker.capture_scores, picker.index);
+
+                if (picker.capture_scores[picker.index] >= 0)
+                {
+                    picker.index++;
+                    return move;
+                }
+            }
+
+            // the rest of captures lose material, leave them for after quiet moves
+            picker.bad_captures = picker.index;
+
+            // quiescence search doesn't need quiet moves (nor losing captures)
+            if (picker.only_captures)
+            {
+                picker.stage = done_stage;
+                return 0;
+            }
+
+            picker.index = 0;
+            picker.stage = killers_stage;
+
+            // fall through
+
+        case killers_stage:
+            // loop over killer moves (picked up before quiet moves are generated)
+            while (picker.index < 2)
+            {
+                // init killer move
+                int killer = MoveGeneration::expand_move(pos, killer_moves[picker.index][pos.ply]);
+
+                // skip empty, tactical or already searched killer moves
+                if (killer && !get_move_tactical(killer) && killer != picker.hash_move && killer != picker.killers[0] &&
+                    // make sure killer move is available in current position
+                    MoveGeneration::is_pseudo_legal(pos, killer) && MoveGeneration::is_legal(pos, picker.check_info, killer))
+                {
+                    picker.killers[picker.index++] = killer;
+                    return killer;
+                }
+
+                picker.index++;
+            }
+
+            picker.stage = init_quiets_stage;
+
+            // fall through
+
+        case init_quiets_stage:
+            // generate quiet moves, take out hash & killer moves already picked up
+            MoveGeneration::generate_moves(pos, picker.quiets, MoveGeneration::only_quiets, picker.check_info);
+
+            if (picker.hash_move && !get_move_tactical(picker.hash_move))
+                remove_move(picker.quiets, picker.hash_move);
+
+            for (int count = 0; count < 2; count++)
+                if (picker.killers[count])
+                    remove_move(picker.quiets, picker.killers[count]);
+
+            // score the rest of quiet moves by history
+            for (int count = 0; count < picker.quiets.count; count++)
+                picker.quiet_scores[count] = history_moves[get_move_piece(picker.quiets.moves[count])][get_move_target(picker.quiets.moves[count])];
+
+            picker.index = 0;
+            picker.stage = quiets_stage;
+
+            // fall through
+
+        case quiets_stage:
+            // pick up the best quiet move left
+            if (picker.index < picker.quiets.count)
+                return pick_best(picker.quiets, picker.quiet_scores, picker.index++);
+
+            picker.index = picker.bad_captures;
+            picker.stage = bad_captures_stage;
+
+            // fall through
+
+        case bad_captures_stage:
+            // pick up the best losing capture left
+            if (picker.index < picker.captures.count)
+                return pick_best(picker.captures, picker.capture_scores, picker.index++);
+
+            picker.stage = done_stage;
+
+            // fall through
+
+        case done_stage:
+            return 0;
+        }
+
+        return 0;
+    }
+
+    // print move scores
+    void print_move_scores(const Position& pos, MoveGeneration::MoveList& move_list)
+    {
+        printf("     Move scores:\n\n");
+
+        // loop over moves within a move list
+        for (int count = 0; count < move_list.count; count++)
+        {
+            printf("     move: ");
+            MoveGeneration::print_move(move_list.moves[count]);
+            printf(" score: %d\n", score_move(pos, move_list.moves[count]));
+        }
+    }
+
+    // position repetition detection
+    static int is_repetition(const Position& pos)
+    {
+        // loop over repetition indicies range
+        for (int index = 0; index < pos.repetition_index; index++)
+            // if we found the hash key same with a current
+            if (pos.repetition_table[index] == pos.hash_key)
+                // we found a repetition
+                return 1;
+
+        // if no repetition found
+        return 0;
+    }
+
+    // quiescence search
+    static int quiescence(Position& pos, int alpha, int beta)
+    {
+        // every 2047 nodes
+        if ((Perft::nodes & 2047) == 0)
+            // "listen" to the GUI/user input
+            Time::communicate();
+
+        // increment nodes count
+        Perft::nodes++;
+        quiescence_nodes++;
+
+        // we are too deep, hence there's an overflow of arrays relying on max ply constant
+        if (pos.ply > MAX_PLY - 1)
+            // evaluate position
+            return Evaluation::evaluate(pos);
+
+        // init check & pin information
+        MoveGeneration::CheckInfo check_info;
+        MoveGeneration::init_check_info(pos, check_info);
+
+        // is king in check
+        int in_check = check_info.checkers != 0;
+
+        // side to move can't stand pat while in check
+        if (!in_check)
+        {
+            // evaluate position
+            int evaluation = Evaluation::evaluate(pos);
+
+            // fail-hard beta cutoff
+            if (evaluation >= beta)
+            {
+                // node (position) fails high
+                return beta;
             }
 
+            // found a better move
+            if (evaluation > alpha)
+            {
+                // PV node (position)
+                alpha = evaluation;
+            }
+        }
+
+        // init move picker (captures only, all check evasions while in check)
+        MovePicker picker;
+        init_picker(picker, 0, !in_check, check_info);
+
+        // legal moves counter
+        int legal_moves = 0;
+
+        // current move
+        int move;
+
+        // loop over moves picked one by one
+        while ((move = next_move(pos, picker)))
+        {
+            // undo record of the move
+            MoveGeneration::Undo undo;
+
+            // increment ply
+            pos.ply++;
+
+            // increment repetition index & store hash key
+            pos.repetition_index++;
+            pos.repetition_table[pos.repetition_index] = pos.hash_key;
+
+            // make move (captures & evasions are generated legal)
+            MoveGeneration::make_move(pos, move, undo);
+
+            // increment legal moves
+            legal_moves++;
+
             // score current move
-            int score = -quiescence(-beta, -alpha);
+            int score = -quiescence(pos, -beta, -alpha);
 
             // decrement ply
-            ply--;
+            pos.ply--;
+
+            // decrement repetition index
+            pos.repetition_index--;
 
             // take move back
-            take_back();
+            MoveGeneration::unmake_move(pos, move, undo);
 
             // reutrn 0 if time is up
             if (Time::stopped == 1) return 0;
@@ -1296,6 +2338,11 @@ namespace Search {
             }
         }
 
+        // checkmate (every evasion has been searched)
+        if (in_check && legal_moves == 0)
+            // return mating score (assuming closest distance to mating position)
+            return -mate_value + pos.ply;
+
         // node (position) fails low
         return alpha;
     }
@@ -1306,7 +2353,7 @@ namespace Search {
     const int reduction_limit = 3;
 
     // negamax alpha beta search
-    static inline int negamax(int alpha, int beta, int depth)
+    static inline int negamax(Position& pos, int alpha, int beta, int depth)
     {
         // variable to store current move's score (from the static evaluation perspective)
         int score;
@@ -1314,8 +2361,11 @@ namespace Search {
         // define hash flag
         int hash_flag = hash_flag_alpha;
 
+        // best move found in the position and the one stored in TT
+        int best_move = 0, hash_move = 0;
+
         // if position repetition occurs
-        if (ply && is_repetition())
+        if (pos.ply && is_repetition(pos))
             // return draw score
             return 0;
 
@@ -1323,7 +2373,7 @@ namespace Search {
         int pv_node = beta - alpha > 1;
 
         // read hash entry
-        if (ply && (score = read_hash_entry(alpha, beta, depth)) != no_hash_entry && !pv_node)
+        if (pos.ply && (score = read_hash_entry(pos, alpha, beta, &hash_move, depth)) != no_hash_entry && !pv_node)
             // if the move has already been searched (hence has a value)
             // we just return the score for this move without searching it
             return score;
@@ -1334,25 +2384,27 @@ namespace Search {
             Time::communicate();
 
         // init PV length
-        pv_length[ply] = ply;
+        pv_length[pos.ply] = pos.ply;
 
         // recursion escapre condition
         if (depth == 0)
-            return quiescence(alpha, beta);
+            return quiescence(pos, alpha, beta);
             
 
         // we are too deep, hence there's an overflow of arrays relying on max ply constant
-        if (ply > MAX_PLY - 1)
+        if (pos.ply > MAX_PLY - 1)
             // evaluate position
-            return Evaluation::evaluate();
+            return Evaluation::evaluate(pos);
 
         // increment nodes count
         Perft::nodes++;
 
+        // init check & pin information (shared with move generation)
+        MoveGeneration::CheckInfo check_info;
+        MoveGeneration::init_check_info(pos, check_info);
+
         // is king in check
-        int in_check = MoveGeneration::is_square_attacked((side == white) ? get_ls1b_index(bitboards[K]) :
-            get_ls1b_index(bitboards[k]),
-            side ^ 1);
+        int in_check = check_info.checkers != 0;
 
         // increase search depth if the king has been exposed into a check
         if (in_check)
@@ -1362,36 +2414,33 @@ namespace Search {
         int legal_moves = 0;
 
         // null move pruning
-        if (depth >= 3 && in_check == 0 && ply)
+        if (depth >= 3 && in_check == 0 && pos.ply)
         {
-            // preserve board state
-            copy_board();
+            // undo record of the null move
+            MoveGeneration::Undo undo;
 
             // increment ply
-            ply++;
+            pos.ply++;
 
             // increment repetition index & store hash key
-            repetition_index++;
-            repetition_table[repetition_index] = hash_key;
+            pos.repetition_index++;
+            pos.repetition_table[pos.repetition_index] = pos.hash_key;
 
             // switch the side, literally giving opponent an extra move to make
-            side ^= 1;
-
-            // reset enpassant capture square
-            enpassant = no_sq;
+            MoveGeneration::make_null_move(pos, undo);
 
             // search moves with reduced depth to find beta cutoffs
                //depth - 1 - R where R is a reduction limit 
-            int score = -negamax(-beta, -beta + 1, depth - 1 - 2);
+            int score = -negamax(pos, -beta, -beta + 1, depth - 1 - 2);
 
             // decrement ply
-            ply--;
+            pos.ply--;
 
             // decrement repetition index
-            repetition_index--;
+            pos.repetition_index--;
 
             // restore board state
-            take_back();
+            MoveGeneration::unmake_null_move(pos, undo);
 
             if (Time::stopped)
                 return 0;
@@ -1402,46 +2451,44 @@ namespace Search {
                 return beta;
         }
 
-        // create move list instance
-        std::vector<int> move_list;
+        // PV move to follow (if we are now following PV line)
+        int pv_move = follow_pv ? MoveGeneration::expand_move(pos, pv_table[0][pos.ply]) : 0;
 
-        // generate moves
-        MoveGeneration::generate_moves(move_list);
-
-        // if we are now following PV line
-        if (follow_pv)
-            // enable PV move scoring
-            enable_pv_scoring(move_list);
+        // stop following PV line unless PV move is picked
+        follow_pv = false;
 
-        // sort moves
-        sort_moves(move_list);
+        // init move picker (PV move takes precedence over hash move)
+        MovePicker picker;
+        init_picker(picker, pv_move ? pv_move : hash_move, 0, check_info);
 
         // number of moves searched in a move list
         int moves_searched = 0;
 
-        // loop over moves within a movelist
-        for (int count = 0; count < move_list.size(); count++)
+        // current move
+        int move;
+
+        // loop over moves picked one by one
+        while ((move = next_move(pos, picker)))
         {
-            // preserve board state
-            copy_board();
+            // keep following PV line through the PV move
+            if (pv_move && move == pv_move)
+                follow_pv = true;
+
+            // does the move give check (known before making it)
+            int check_move = MoveGeneration::gives_check(pos, check_info, move);
+
+            // undo record of the move
+            MoveGeneration::Undo undo;
 
             // increment ply
-            ply++;
+            pos.ply++;
 
             // increment repetition index & store hash key
-            repetition_index++;
-            repetition_table[repetition_index] = hash_key;
+            pos.repetition_index++;
+            pos.repetition_table[pos.repetition_index] = pos.hash_key;
 
-            // make sure to make only legal moves
-            if (MoveGeneration::make_move(move_list[count], MoveGeneration::all_moves) == 0)
-            {
-                ply--;
-
-                // decrement repetition index
-                repetition_index--;
-
-                continue;
-            }
+            // make move (moves are generated legal)
+            MoveGeneration::make_move(pos, move, undo);
 
             // increment legal moves
             legal_moves++;
@@ -1452,7 +2499,7 @@ namespace Search {
             // full depth search
             if (moves_searched == 0)
                 // do normal alpha beta search
-                score = -negamax(-beta, -alpha, depth - 1);
+                score = -negamax(pos, -beta, -alpha, depth - 1);
 
             // late move reduction (LMR)
             else
@@ -1462,11 +2509,12 @@ namespace Search {
                     moves_searched >= full_depth_moves &&
                     depth >= reduction_limit &&
                     in_check == 0 &&
-                    get_move_capture(move_list[count]) == 0 &&
-                    get_move_promoted(move_list[count]) == 0
+                    check_move == 0 &&
+                    get_move_capture(move) == 0 &&
+                    get_move_promoted(move) == 0
                     )
                     // search current move with reduced depth:
-                    score = -negamax(-alpha - 1, -alpha, depth - 2);
+                    score = -negamax(pos, -alpha - 1, -alpha, depth - 2);
 
                 // hack to ensure that full-depth search is done
                 else score = alpha + 1;
@@ -1478,7 +2526,7 @@ namespace Search {
                        the rest of the moves are searched with the goal of proving that they are all bad.
                        It's possible to do this a bit faster than a search that worries that one
                        of the remaining moves might be good. */
-                    score = -negamax(-alpha - 1, -alpha, depth - 1);
+                    score = -negamax(pos, -alpha - 1, -alpha, depth - 1);
 
                     /* If the algorithm finds out that it was wrong, and that one of the
                        subsequent moves was better than the first PV move, it has to search again,
@@ -1488,18 +2536,18 @@ namespace Search {
                     if ((score > alpha) && (score < beta))
                         /* re-search the move that has failed to be proved to be bad
                            with normal alpha beta score bounds*/
-                        score = -negamax(-beta, -alpha, depth - 1);
+                        score = -negamax(pos, -beta, -alpha, depth - 1);
                 }
             }
 
             // decrement ply
-            ply--;
+            pos.ply--;
 
             // decrement repetition index
-            repetition_index--;
+            pos.repetition_index--;
 
             // take move back
-            take_back();
+            MoveGeneration::unmake_move(pos, move, undo);
 
             if (Time::stopped)
                 return 0;
@@ -1513,156 +2561,1072 @@ namespace Search {
                 // to the one storing score for PV node
                 hash_flag = hash_flag_exact;
 
-                // on quiet moves
-                if (get_move_capture(move_list[count]) == 0)
-                    // store history moves
-                    history_moves[get_move_piece(move_list[count])][get_move_target(move_list[count])] += depth;
+                // store best move
+                best_move = move;
+
+                // on quiet moves
+                if (get_move_tactical(move) == 0)
+                    // store history moves
+                    history_moves[get_move_piece(move)][get_move_target(move)] += depth;
+
+                // PV node (position)
+                alpha = score;
+
+                // write PV move
+                pv_table[pos.ply][pos.ply] = compact_move(move);
+
+                // loop over the next ply
+                for (int next_ply = pos.ply + 1; next_ply < pv_length[pos.ply + 1]; next_ply++)
+                    // copy move from deeper ply into a current ply's line
+                    pv_table[pos.ply][next_ply] = pv_table[pos.ply + 1][next_ply];
+
+                // adjust PV length
+                pv_length[pos.ply] = pv_length[pos.ply + 1];
+
+                // fail-hard beta cutoff
+                if (score >= beta)
+                {
+                    // store hash entry with the score equal to beta
+                    write_hash_entry(pos, beta, move, depth, hash_flag_beta);
+
+                    // on quiet moves
+                    if (get_move_tactical(move) == 0)
+                    {
+                        // store killer moves
+                        killer_moves[1][pos.ply] = killer_moves[0][pos.ply];
+                        killer_moves[0][pos.ply] = compact_move(move);
+                    }
+
+                    // node (position) fails high
+                    return beta;
+                }
+            }
+        }
+
+        // we don't have any legal moves to make in the current postion
+        if (legal_moves == 0)
+        {
+            // king is in check
+            if (in_check)
+                // return mating score (assuming closest distance to mating position)
+                return -mate_value + pos.ply;
+
+            // king is not in check
+            else
+                // return stalemate score
+                return 0;
+        }
+
+        // store hash entry with the score equal to alpha
+        write_hash_entry(pos, alpha, best_move, depth, hash_flag);
+
+        // node (move) fails low
+        return alpha;
+    }
+    
+    // search position for the best move
+    void search_position(Position& pos, int depth)
+    {
+        // find best move within a given position
+        int score = 0;
+
+        // reset nodes counters
+        Perft::nodes = 0;
+        quiescence_nodes = 0;
+
+        Time::stopped = 0;
+
+        // reset follow PV flag
+        follow_pv = false;
+
+        // clear helper data structures for search
+        memset(killer_moves, 0, sizeof(killer_moves));
+        memset(history_moves, 0, sizeof(history_moves));
+        memset(pv_table, 0, sizeof(pv_table));
+        memset(pv_length, 0, sizeof(pv_length));
+
+        // allocate TT on the first search (perft & other commands don't need it)
+        if (hash_table == NULL)
+            init_hash_table(hash_megabytes);
+
+        // age TT entries & reset TT statistics
+        new_hash_search();
+
+        // define initial alpha beta bounds
+        int alpha = -infinity;
+        int beta = infinity;
+
+        // iterative deepening
+        for (int current_depth = 1; current_depth <= depth; current_depth++)
+        {
+            if (Time::stopped)
+                break;
+
+            follow_pv = true;
+
+            // find best move within a given position
+            score = negamax(pos, alpha, beta, current_depth);
+
+            // we fell outside the window, so try again with a full-width window (and the same depth)
+            if ((score <= alpha) || (score >= beta)) {
+                alpha = -infinity;
+                beta = infinity;
+                continue;
+            }
+
+            // set up the window for the next iteration
+            alpha = score - 50;
+            beta = score + 50;
+
+            if (score > -mate_value && score < -mate_score)
+                printf("info score mate %d depth %d nodes %lld time %d hashfull %d pv ", -(score + mate_value) / 2 - 1, current_depth, Perft::nodes, Time::get_time_ms() - Time::starttime, hash_full());
+
+            else if (score > mate_score && score < mate_value)
+                printf("info score mate %d depth %d nodes %lld time %d hashfull %d pv ", (mate_value - score) / 2 + 1, current_depth, Perft::nodes, Time::get_time_ms() - Time::starttime, hash_full());
+
+            else
+                printf("info score cp %d depth %d nodes %lld time %d hashfull %d pv ", score, current_depth, Perft::nodes, Time::get_time_ms() - Time::starttime, hash_full());
+
+            
+
+            // loop over the moves within a PV line
+            for (int count = 0; count < pv_length[0]; count++)
+            {
+                // print PV move
+                MoveGeneration::print_compact_move(pv_table[0][count]);
+                printf(" ");
+            }
+
+            // print new line
+            printf("\n");
+        }
+
+        // TT statistics of the search
+        printf("info string hash hits %ld of %ld probes (%.1f%%)\n", hash_hits, hash_probes, hash_probes ? hash_hits * 100.0 / hash_probes : 0.0);
+
+        // best move placeholder
+        printf("bestmove ");
+        MoveGeneration::print_compact_move(pv_table[0][0]);
+        printf("\n");
+
+
+    }
+
+}
+
+void init_all()
+{
+    // attack tables, hash keys & evaluation masks are generated at compile time
+    // (slider tables at start up unless CONSTEXPR_SLIDERS is set),
+    // hash table is allocated by the first search (or UCI "Hash" option)
+    Attacks::init_slider_tables();
+    Attacks::init_sliders_backend();
+}
+
+namespace Bench
+{
+    // number of heap allocations made since the counter was last reset (operator new runs on any thread)
+    std::atomic<long> allocations(0);
+
+    // count heap allocations only while allocation bench is running
+    std::atomic<int> count_allocations(0);
+
+    // bench positions
+    const char* positions[] = { start_position, tricky_position, killer_position, cmk_position };
+
+    // bench position instance (keeps the game position intact)
+    Position pos;
+
+    // make sure perft & search make no heap allocations per node
+    void allocation_bench(int depth)
+    {
+        std::cout << "\n     Allocation bench\n\n";
+
+        // total nodes & allocations
+        long long total_nodes = 0;
+        long total_allocations = 0;
+
+        // allocate TT before counting (one time set up, not a per node allocation)
+        if (Search::hash_table == NULL)
+            Search::init_hash_table(Search::hash_megabytes);
+
+        // start counting heap allocations
+        count_allocations = 1;
+
+        // loop over bench positions
+        for (const char* fen : positions)
+        {
+            // init position
+            parse_fen(pos, fen);
+
+            // reset counters
+            allocations = 0;
+            Perft::nodes = 0;
+
+            // run perft
+            Perft::perft_driver(pos, depth);
+
+            // store perft results
+            long long perft_nodes = Perft::nodes;
+            long perft_allocations = allocations;
+
+            // reset allocations counter (search resets nodes itself)
+            allocations = 0;
+
+            // run fixed depth search
+            Search::search_position(pos, depth);
+
+            // print results
+            printf("\n     perft nodes: %lld  allocations: %ld\n", perft_nodes, perft_allocations);
+            printf("    search nodes: %lld  allocations: %ld\n\n", Perft::nodes, allocations.load());
+
+            // update totals
+            total_nodes += perft_nodes + Perft::nodes;
+            total_allocations += perft_allocations + allocations;
+        }
+
+        // stop counting heap allocations
+        count_allocations = 0;
+
+        // print summary
+        printf("     Total nodes: %lld\n", total_nodes);
+        printf("     Total allocations: %ld\n", total_allocations);
+        printf("     Allocations per node: %.6f\n\n", total_nodes ? (double)total_allocations / total_nodes : 0.0);
+    }
+
+    // move generator throughput: perft speed (with & without bulk counting) & legal move generation calls per position
+    void movegen_bench(int depth)
+    {
+        std::cout << "\n     Move generation bench\n\n";
+
+        // number of move generator calls per position
+        const int calls = 1000000;
+
+        // total nodes & time (bulk counting and making every leaf move)
+        long long total_nodes = 0;
+        long total_time = 0, total_bulk_time = 0;
+
+        // preserve bulk counting option
+        int bulk_counting = Perft::bulk_counting;
+
+        // loop over bench positions
+        for (const char* fen : positions)
+        {
+            // init position
+            parse_fen(pos, fen);
+
+            // run perft with bulk counting
+            Perft::bulk_counting = 1;
+            Perft::nodes = 0;
+            long start = Time::get_time_ms();
+            Perft::perft_driver(pos, depth);
+            long bulk_ms = Time::get_time_ms() - start;
+            long long bulk_nodes = Perft::nodes;
+
+            // run perft making every leaf move
+            Perft::bulk_counting = 0;
+            Perft::nodes = 0;
+            start = Time::get_time_ms();
+            Perft::perft_driver(pos, depth);
+            long perft_ms = Time::get_time_ms() - start;
+
+            // generate moves over and over in the same position
+            MoveGeneration::MoveList move_list;
+            long moves = 0;
+            start = Time::get_time_ms();
+
+            for (int count = 0; count < calls; count++)
+            {
+                MoveGeneration::generate_moves(pos, move_list);
+                moves += move_list.count;
+            }
+
+            long generation_ms = Time::get_time_ms() - start;
+
+            // print results
+            printf("     nodes: %lld  time: %ld ms  nps: %lld  bulk: %ld ms  nps: %lld  movegen: %.1f ns/call (%ld moves)%s\n",
+                Perft::nodes, perft_ms, perft_ms ? Perft::nodes * 1000 / perft_ms : 0, bulk_ms, bulk_ms ? bulk_nodes * 1000 / bulk_ms : 0,
+                generation_ms * 1000000.0 / calls, moves / calls, bulk_nodes != Perft::nodes ? "  NODE COUNT MISMATCH" : "");
+
+            // update totals
+            total_nodes += Perft::nodes;
+            total_time += perft_ms;
+            total_bulk_time += bulk_ms;
+        }
+
+        // restore bulk counting option
+        Perft::bulk_counting = bulk_counting;
+
+        // print summary
+        printf("\n     Total nodes: %lld  time: %ld ms  nps: %lld\n", total_nodes, total_time, total_time ? total_nodes * 1000 / total_time : 0);
+        printf("     Bulk counting: %ld ms  nps: %lld\n\n", total_bulk_time, total_bulk_time ? total_nodes * 1000 / total_bulk_time : 0);
+    }
+
+    // hashed perft against unhashed perft (node counts must match)
+    void perft_hash_bench(int depth)
+    {
+        std::cout << "\n     Perft hash bench\n\n";
+
+        // use 16 MB perft hash table unless it's already allocated
+        int own_table = Perft::perft_hash_entries == 0;
+
+        if (own_table)
+            Perft::init_perft_hash(16);
+
+        // hash table size in entries
+        long entries = Perft::perft_hash_entries;
+
+        // total nodes & time of both runs
+        long long total_nodes = 0;
+        long plain_time = 0, hash_time = 0, mismatches = 0;
+
+        // loop over bench positions
+        for (const char* fen : positions)
+        {
+            // init position
+            parse_fen(pos, fen);
+
+            // run unhashed perft
+            Perft::perft_hash_entries = 0;
+            Perft::nodes = 0;
+            long start = Time::get_time_ms();
+            Perft::perft_driver(pos, depth);
+            long plain_ms = Time::get_time_ms() - start;
+            long long plain_nodes = Perft::nodes;
+
+            // run hashed perft on a cleared table
+            Perft::perft_hash_entries = entries;
+            Perft::clear_perft_hash();
+            Perft::nodes = 0;
+            start = Time::get_time_ms();
+            Perft::perft_driver(pos, depth);
+            long hash_ms = Time::get_time_ms() - start;
+
+            // print results
+            printf("     nodes: %lld  unhashed: %ld ms  hashed: %ld ms%s\n",
+                plain_nodes, plain_ms, hash_ms, plain_nodes != Perft::nodes ? "  NODE COUNT MISMATCH" : "");
+
+            // update totals
+            total_nodes += plain_nodes;
+            plain_time += plain_ms;
+            hash_time += hash_ms;
+            mismatches += plain_nodes != Perft::nodes;
+        }
+
+        // release bench table
+        if (own_table)
+            Perft::init_perft_hash(0);
+
+        // print summary
+        printf("\n     Total nodes: %lld  mismatches: %ld\n", total_nodes, mismatches);
+        printf("     unhashed: %ld ms (%lld nps)\n", plain_time, plain_time ? total_nodes * 1000 / plain_time : 0);
+        printf("     hashed:   %ld ms (%lld nps)\n\n", hash_time, hash_time ? total_nodes * 1000 / hash_time : 0);
+    }
+
+    // parallel perft scaling: speedup & efficiency by number of threads
+    void perft_threads_bench(int depth)
+    {
+        // number of hardware threads
+        int max_threads = Perft::perft_threads();
+
+        printf("\n     Parallel perft bench (%d hardware threads)\n\n", max_threads);
+
+        // root moves (not needed here)
+        MoveGeneration::MoveList root_moves;
+
+        // node count & time on a single thread
+        long long single_nodes = 0;
+        long single_time = 0;
+
+        // loop over doubling number of threads (max number of threads included)
+        for (int threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads)
+        {
+            // total nodes & time over bench positions
+            long long total_nodes = 0;
+            long total_time = 0;
+
+            // loop over bench positions
+            for (const char* fen : positions)
+            {
+                parse_fen(pos, fen);
+
+                long start = Time::get_time_ms();
+                total_nodes += Perft::parallel_perft(pos, depth, threads, root_moves);
+                total_time += Time::get_time_ms() - start;
+            }
+
+            // single thread reference
+            if (threads == 1)
+            {
+                single_nodes = total_nodes;
+                single_time = total_time;
+            }
+
+            // speedup & efficiency against single thread
+            double speedup = total_time ? (double)single_time / total_time : 0.0;
+
+            printf("     threads: %2d  nodes: %lld  time: %ld ms  nps: %lld  speedup: %.2f  efficiency: %.0f%%%s\n",
+                threads, total_nodes, total_time, total_time ? total_nodes * 1000 / total_time : 0,
+                speedup, speedup * 100 / threads, total_nodes != single_nodes ? "  NODE COUNT MISMATCH" : "");
+
+            if (threads == max_threads)
+                break;
+        }
+
+        printf("\n");
+    }
+
+    // compare make/unmake against copy-make in perft
+    void make_move_bench(int depth)
+    {
+        std::cout << "\n     Make/unmake bench\n\n";
+
+        // total nodes & time of both perft drivers
+        long long total_nodes = 0;
+        long unmake_time = 0, copy_time = 0;
+
+        // make every leaf move, as copy-make driver does
+        int bulk_counting = Perft::bulk_counting;
+        Perft::bulk_counting = 0;
+
+        // loop over bench positions
+        for (const char* fen : positions)
+        {
+            // init position
+            parse_fen(pos, fen);
+
+            // run perft with make/unmake
+            Perft::nodes = 0;
+            long start = Time::get_time_ms();
+            Perft::perft_driver(pos, depth);
+            long unmake_ms = Time::get_time_ms() - start;
+            long long unmake_nodes = Perft::nodes;
+
+            // run perft with copy-make
+            Perft::nodes = 0;
+            start = Time::get_time_ms();
+            Perft::perft_copy_driver(pos, depth);
+            long copy_ms = Time::get_time_ms() - start;
+
+            // print results
+            printf("     nodes: %lld  make/unmake: %ld ms  copy-make: %ld ms%s\n",
+                unmake_nodes, unmake_ms, copy_ms, unmake_nodes != Perft::nodes ? "  NODE COUNT MISMATCH" : "");
+
+            // update totals
+            total_nodes += unmake_nodes;
+            unmake_time += unmake_ms;
+            copy_time += copy_ms;
+        }
+
+        // restore bulk counting option
+        Perft::bulk_counting = bulk_counting;
+
+        // print summary
+        printf("\n     Total nodes: %lld\n", total_nodes);
+        printf("     make/unmake: %ld ms (%lld nps)\n", unmake_time, unmake_time ? total_nodes * 1000 / unmake_time : 0);
+        printf("     copy-make:   %ld ms (%lld nps)\n\n", copy_time, copy_time ? total_nodes * 1000 / copy_time : 0);
+    }
+
+    // time bit primitives against their portable versions (nanoseconds per call)
+    void bit_bench()
+    {
+        std::cout << "\n     Bit primitives bench (BIT_ISA " << BIT_ISA << ")\n\n";
+
+        // sparse random bitboards (about 8 bits set, like piece bitboards)
+        static U64 bitboards_sample[4096];
+        for (int index = 0; index < 4096; index++)
+            bitboards_sample[index] = Zobrist::get_random_U64_number() &
+                Zobrist::get_random_U64_number() & Zobrist::get_random_U64_number();
+
+        // number of calls per primitive
+        const long calls = 50000000;
+
+        // results sum (so the calls can't be optimized away)
+        long sum = 0;
+
+        // primitives to time
+        const char* names[] = { "count_bits", "count_bits_portable", "get_ls1b_index", "get_ls1b_index_portable" };
+
+        // loop over primitives
+        for (int primitive = 0; primitive < 4; primitive++)
+        {
+            long start = Time::get_time_ms();
+
+            // call primitive over the sample bitboards
+            for (long call = 0; call < calls; call++)
+            {
+                U64 bitboard = bitboards_sample[call & 4095];
+
+                switch (primitive)
+                {
+                case 0: sum += count_bits(bitboard); break;
+                case 1: sum += count_bits_portable(bitboard); break;
+                case 2: sum += get_ls1b_index(bitboard); break;
+                case 3: sum += get_ls1b_index_portable(bitboard); break;
+                }
+            }
+
+            // print results
+            long time = Time::get_time_ms() - start;
+            printf("     %-24s %6ld ms  %.2f ns/call\n", names[primitive], time, time * 1000000.0 / calls);
+        }
+
+        printf("\n     checksum: %ld\n\n", sum);
+    }
+
+    // slider lookups (square & occupancy) recorded from real positions
+    const int max_lookups = 1 << 20;
+    int lookup_squares[max_lookups];
+    U64 lookup_occupancies[max_lookups];
+    int lookup_count;
+
+    // record slider lookups made by move generation in positions reached by perft
+    void record_lookups(Position& pos, int depth)
+    {
+        // loop over side to move's bishops, rooks & queens
+        for (int piece = B; piece <= Q; piece++)
+        {
+            U64 bitboard = pos.bitboards[(pos.side == white) ? piece : piece + 6];
+
+            while (bitboard && lookup_count < max_lookups)
+            {
+                // record slider square & board occupancy
+                lookup_squares[lookup_count] = get_ls1b_index(bitboard);
+                lookup_occupancies[lookup_count++] = pos.occupancies[both];
+
+                pop_bit(bitboard, get_ls1b_index(bitboard));
+            }
+        }
+
+        // reccursion escape condition
+        if (depth == 0) return;
+
+        // generate moves
+        MoveGeneration::MoveList move_list;
+        MoveGeneration::generate_moves(pos, move_list);
+
+        // loop over generated moves
+        for (int move_count = 0; move_count < move_list.count; move_count++)
+        {
+            MoveGeneration::Undo undo;
+            MoveGeneration::make_move(pos, move_list.moves[move_count], undo);
+            record_lookups(pos, depth - 1);
+            MoveGeneration::unmake_move(pos, move_list.moves[move_count], undo);
+        }
+    }
 
-                // PV node (position)
-                alpha = score;
+    // verify slider attack tables against on the fly attacks & time the lookups
+    void attack_bench()
+    {
+        std::cout << "\n     Slider attacks bench (" << (Attacks::pext_enabled ? "pext" : "magic") << " backend)\n\n";
 
-                // write PV move
-                pv_table[ply][ply] = move_list[count];
+        // slider attack tables footprint
+        printf("     slider attack tables: %ld KB\n", (long)(sizeof(Attacks::slider_attacks) / 1024));
 
-                // loop over the next ply
-                for (int next_ply = ply + 1; next_ply < pv_length[ply + 1]; next_ply++)
-                    // copy move from deeper ply into a current ply's line
-                    pv_table[ply][next_ply] = pv_table[ply + 1][next_ply];
+        // table entries checked & mismatches found
+        long entries = 0, mismatches = 0;
 
-                // adjust PV length
-                pv_length[ply] = pv_length[ply + 1];
+        // loop over 64 board squares
+        for (int square = 0; square < 64; square++)
+        {
+            // loop over bishop & rook
+            for (int bishop_piece = 0; bishop_piece < 2; bishop_piece++)
+            {
+                // init current mask & relevant occupancy bit count
+                U64 attack_mask = bishop_piece ? Attacks::bishop_masks[square] : Attacks::rook_masks[square];
+                int relevant_bits_count = count_bits(attack_mask);
 
-                // fail-hard beta cutoff
-                if (score >= beta)
+                // loop over all occupancy variations of the mask
+                for (int index = 0; index < (1 << relevant_bits_count); index++)
                 {
-                    // store hash entry with the score equal to beta
-                    write_hash_entry(beta, depth, hash_flag_beta);
+                    U64 occupancy = Attacks::set_occupancy(index, relevant_bits_count, attack_mask);
 
-                    // on quiet moves
-                    if (get_move_capture(move_list[count]) == 0)
-                    {
-                        // store killer moves
-                        killer_moves[1][ply] = killer_moves[0][ply];
-                        killer_moves[0][ply] = move_list[count];
-                    }
+                    // compare table lookup with on the fly attacks
+                    U64 attacks = bishop_piece ? Attacks::get_bishop_attacks(square, occupancy) : Attacks::get_rook_attacks(square, occupancy);
+                    U64 expected = bishop_piece ? Attacks::bishop_attacks_on_the_fly(square, occupancy) : Attacks::rook_attacks_on_the_fly(square, occupancy);
 
-                    // node (position) fails high
-                    return beta;
+                    entries++;
+                    if (attacks != expected) mismatches++;
                 }
             }
         }
 
-        // we don't have any legal moves to make in the current postion
-        if (legal_moves == 0)
-        {
-            // king is in check
-            if (in_check)
-                // return mating score (assuming closest distance to mating position)
-                return -mate_value + ply;
+        printf("     table entries checked: %ld  mismatches: %ld\n", entries, mismatches);
 
-            // king is not in check
-            else
-                // return stalemate score
-                return 0;
+        // random occupancies (about 16 pieces on board)
+        static U64 occupancy_sample[4096];
+        for (int index = 0; index < 4096; index++)
+            occupancy_sample[index] = Zobrist::get_random_U64_number() & Zobrist::get_random_U64_number();
+
+        // number of lookups
+        const long lookups = 50000000;
+
+        // lookup results (so the lookups can't be optimized away)
+        U64 sum = 0;
+
+        long start = Time::get_time_ms();
+
+        // time queen attacks lookups over random occupancies (bishop & rook table each)
+        for (long lookup = 0; lookup < lookups; lookup++)
+            sum += Attacks::get_queen_attacks(lookup & 63, occupancy_sample[lookup & 4095]);
+
+        long time = Time::get_time_ms() - start;
+        printf("     random occupancies:  %ld ms  %.2f ns/call  (checksum %llu)\n", time, time * 1000000.0 / lookups, sum);
+
+        // record slider lookups from the bench positions
+        lookup_count = 0;
+        for (const char* fen : positions)
+        {
+            parse_fen(pos, fen);
+            record_lookups(pos, 3);
         }
 
-        // store hash entry with the score equal to alpha
-        write_hash_entry(alpha, depth, hash_flag);
+        start = Time::get_time_ms();
 
-        // node (move) fails low
-        return alpha;
+        // replay recorded lookups
+        for (long lookup = 0, index = 0; lookup < lookups; lookup++, index = (index + 1 < lookup_count) ? index + 1 : 0)
+            sum += Attacks::get_queen_attacks(lookup_squares[index], lookup_occupancies[index]);
+
+        time = Time::get_time_ms() - start;
+        printf("     search positions:    %ld ms  %.2f ns/call  (checksum %llu, %d lookups recorded)\n\n", time, time * 1000000.0 / lookups, sum, lookup_count);
     }
-    
-    // search position for the best move
-    void search_position(int depth)
+
+    // tactical positions (Win At Chess) with their best moves
+    const char* tactical_positions[][2] = {
+        { "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - 0 1", "g3g6" },
+        { "8/7p/5k2/5p2/p1p2P2/Pr1pPK2/1P1R3P/8 b - - 0 1", "b3b2" },
+        { "5rk1/1ppb3p/p1pb4/6q1/3P1p1r/2P1R2P/PP1BQ1P1/5RKN w - - 0 1", "e3g3" },
+        { "r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - 0 1", "h6h7" },
+        { "5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - 0 1", "c6c4" },
+        { "7k/p7/1R5K/6r1/6p1/6P1/8/8 w - - 0 1", "b6b7" },
+        { "rnbqkb1r/pppp1ppp/8/4P3/6n1/7P/PPPNPPP1/R1BQKBNR b KQkq - 0 1", "g4e3" },
+        { "r4q1k/p2bR1rp/2p2Q1N/5p2/5p2/2P5/PP3PPP/R5K1 w - - 0 1", "e7f7" },
+        { "3q1rk1/p4pp1/2pb3p/3p4/6Pr/1PNQ4/P1PB1PP1/4RRK1 b - - 0 1", "d6h2" },
+        { "2br2k1/2q3rn/p2NppQ1/2p1P3/Pp5R/4P3/1P3PPP/3R2K1 w - - 0 1", "h4h7" }
+    };
+
+    // fixed depth search over bench & tactical positions (search nodes, quiescence nodes & solved tactics)
+    void search_bench(int depth)
     {
-        // find best move within a given position
-        int score = 0;
+        std::cout << "\n     Search bench\n\n";
 
-        // reset nodes counter
-        Perft::nodes = 0;
+        // totals
+        long long total_nodes = 0;
+        long total_quiescence_nodes = 0, total_time = 0;
+        long total_probes = 0, total_hits = 0;
+        int solved = 0;
 
-        Time::stopped = 0;
+        // number of tactical positions
+        int tactical_count = sizeof(tactical_positions) / sizeof(tactical_positions[0]);
 
-        // reset follow PV flags
-        follow_pv = false;
-        score_pv = false;
+        // loop over bench positions followed by tactical positions
+        for (int index = 0; index < 4 + tactical_count; index++)
+        {
+            // init position
+            parse_fen(pos, index < 4 ? positions[index] : tactical_positions[index - 4][0]);
 
-        // clear helper data structures for search
-        memset(killer_moves, 0, sizeof(killer_moves));
-        memset(history_moves, 0, sizeof(history_moves));
-        memset(pv_table, 0, sizeof(pv_table));
-        memset(pv_length, 0, sizeof(pv_length));
+            // search position
+            long start = Time::get_time_ms();
+            Search::search_position(pos, depth);
+            long time = Time::get_time_ms() - start;
 
-        // define initial alpha beta bounds
-        int alpha = -infinity;
-        int beta = infinity;
+            // best move found
+            int best_move = Search::pv_table[0][0];
+            std::string move_string = square_to_coordinates[get_move_source(best_move)] + square_to_coordinates[get_move_target(best_move)];
 
-        // iterative deepening
-        for (int current_depth = 1; current_depth <= depth; current_depth++)
+            // print results
+            printf("\n     nodes: %lld  quiescence nodes: %ld  time: %ld ms  hash hits: %.1f%%  hashfull: %d  best move: %s",
+                Perft::nodes, Search::quiescence_nodes, time, Search::hash_probes ? Search::hash_hits * 100.0 / Search::hash_probes : 0.0,
+                Search::hash_full(), move_string.c_str());
+
+            // check tactical solution
+            if (index >= 4)
+            {
+                int found = (move_string == tactical_positions[index - 4][1]);
+                solved += found;
+                printf("  (expected %s%s)", tactical_positions[index - 4][1], found ? "" : ", missed");
+            }
+
+            printf("\n\n");
+
+            // update totals
+            total_nodes += Perft::nodes;
+            total_quiescence_nodes += Search::quiescence_nodes;
+            total_time += time;
+            total_probes += Search::hash_probes;
+            total_hits += Search::hash_hits;
+        }
+
+        // print summary
+        printf("     Total nodes: %lld  quiescence nodes: %ld  time: %ld ms\n", total_nodes, total_quiescence_nodes, total_time);
+        printf("     Hash hits: %ld of %ld probes (%.1f%%)\n", total_hits, total_probes, total_probes ? total_hits * 100.0 / total_probes : 0.0);
+        printf("     Tactics solved: %d/%d\n\n", solved, tactical_count);
+    }
+
+    // perft suite position (FEN & reference node counts)
+    typedef struct {
+        const char* fen;            // position
+        long long nodes[6];         // node counts of depths 1 - 6 (0 if the depth is not in the suite)
+    } PerftSuiteEntry;
+
+    // perft suite (bench positions, Chess Programming Wiki & perftsuite.epd positions)
+    const PerftSuiteEntry perft_suite[] = {
+        // bench positions
+        { start_position, { 20, 400, 8902, 197281, 4865609, 119060324 } },
+        { tricky_position, { 48, 2039, 97862, 4085603, 193690690 } },
+        { killer_position, { 42, 1088, 39518, 1032012, 36112837 } },
+        { cmk_position, { 43, 1289, 54240, 1679340, 69838845 } },
+
+        // Chess Programming Wiki perft positions 3 - 6 (4 & its mirror)
+        { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", { 14, 191, 2812, 43238, 674624, 11030083 } },
+        { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", { 6, 264, 9467, 422333, 15833292 } },
+        { "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", { 6, 264, 9467, 422333, 15833292 } },
+        { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", { 44, 1486, 62379, 2103487, 89941194 } },
+        { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", { 46, 2079, 89890, 3894594, 164075551 } },
+
+        // castling
+        { "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1", { 26, 568, 13744, 314346, 7594526 } },
+        { "r3k2r/8/8/8/8/8/8/1R2K2R w Kkq - 0 1", { 25, 567, 14095, 328965, 8153719 } },
+        { "r3k2r/8/8/8/8/8/8/2R1K2R w Kkq - 0 1", { 25, 548, 13502, 312835, 7736373 } },
+        { "r3k2r/8/8/8/8/8/8/R3K1R1 w Qkq - 0 1", { 25, 547, 13579, 316214, 7878456 } },
+        { "1r2k2r/8/8/8/8/8/8/R3K2R w KQk - 0 1", { 26, 583, 14252, 334705, 8198901 } },
+        { "2r1k2r/8/8/8/8/8/8/R3K2R w KQk - 0 1", { 25, 560, 13592, 317324, 7710115 } },
+        { "r3k1r1/8/8/8/8/8/8/R3K2R w KQq - 0 1", { 25, 560, 13607, 320792, 7848606 } },
+        { "4k3/8/8/8/8/8/8/4K2R w K - 0 1", { 15, 66, 1197, 7059, 133987, 764643 } },
+        { "4k3/8/8/8/8/8/8/R3K3 w Q - 0 1", { 16, 71, 1287, 7626, 145232, 846648 } },
+        { "4k2r/8/8/8/8/8/8/4K3 w k - 0 1", { 5, 75, 459, 8290, 47635, 899442 } },
+        { "r3k3/8/8/8/8/8/8/4K3 w q - 0 1", { 5, 80, 493, 8897, 52710, 1001523 } },
+        { "4k3/8/8/8/8/8/8/R3K2R w KQ - 0 1", { 26, 112, 3189, 17945, 532933, 2788982 } },
+        { "r3k2r/8/8/8/8/8/8/4K3 w kq - 0 1", { 5, 130, 782, 22180, 118882, 3517770 } },
+        { "8/8/8/8/8/8/6k1/4K2R w K - 0 1", { 12, 38, 564, 2219, 37735, 185867 } },
+        { "8/8/8/8/8/8/1k6/R3K3 w Q - 0 1", { 15, 65, 1018, 4573, 80619, 413018 } },
+        { "4k2r/6K1/8/8/8/8/8/8 w k - 0 1", { 3, 32, 134, 2073, 10485, 179869 } },
+        { "r3k3/1K6/8/8/8/8/8/8 w q - 0 1", { 4, 49, 243, 3991, 20780, 367724 } },
+        { "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1", { 26, 568, 13744, 314346, 7594526 } },
+        { "r3k2r/8/8/8/8/8/8/1R2K2R b Kkq - 0 1", { 26, 583, 14252, 334705, 8198901 } },
+        { "r3k2r/8/8/8/8/8/8/2R1K2R b Kkq - 0 1", { 25, 560, 13592, 317324, 7710115 } },
+        { "r3k2r/8/8/8/8/8/8/R3K1R1 b Qkq - 0 1", { 25, 560, 13607, 320792, 7848606 } },
+        { "1r2k2r/8/8/8/8/8/8/R3K2R b KQk - 0 1", { 25, 567, 14095, 328965, 8153719 } },
+        { "2r1k2r/8/8/8/8/8/8/R3K2R b KQk - 0 1", { 25, 548, 13502, 312835, 7736373 } },
+        { "r3k1r1/8/8/8/8/8/8/R3K2R b KQq - 0 1", { 25, 547, 13579, 316214, 7878456 } },
+        { "4k3/8/8/8/8/8/8/4K2R b K - 0 1", { 5, 75, 459, 8290, 47635, 899442 } },
+        { "4k3/8/8/8/8/8/8/R3K3 b Q - 0 1", { 5, 80, 493, 8897, 52710, 1001523 } },
+        { "4k2r/8/8/8/8/8/8/4K3 b k - 0 1", { 15, 66, 1197, 7059, 133987, 764643 } },
+        { "r3k3/8/8/8/8/8/8/4K3 b q - 0 1", { 16, 71, 1287, 7626, 145232, 846648 } },
+        { "4k3/8/8/8/8/8/8/R3K2R b KQ - 0 1", { 5, 130, 782, 22180, 118882, 3517770 } },
+        { "r3k2r/8/8/8/8/8/8/4K3 b kq - 0 1", { 26, 112, 3189, 17945, 532933, 2788982 } },
+        { "8/8/8/8/8/8/6k1/4K2R b K - 0 1", { 3, 32, 134, 2073, 10485, 179869 } },
+        { "8/8/8/8/8/8/1k6/R3K3 b Q - 0 1", { 4, 49, 243, 3991, 20780, 367724 } },
+        { "4k2r/6K1/8/8/8/8/8/8 b k - 0 1", { 12, 38, 564, 2219, 37735, 185867 } },
+        { "r3k3/1K6/8/8/8/8/8/8 b q - 0 1", { 15, 65, 1018, 4573, 80619, 413018 } },
+
+        // knights
+        { "8/1n4N1/2k5/8/8/5K2/1N4n1/8 w - - 0 1", { 14, 195, 2760, 38675, 570726, 8107539 } },
+        { "8/1k6/8/5N2/8/4n3/8/2K5 w - - 0 1", { 11, 156, 1636, 20534, 223507, 2594412 } },
+        { "8/8/4k3/3Nn3/3nN3/4K3/8/8 w - - 0 1", { 19, 289, 4442, 73584, 1198299, 19870403 } },
+        { "K7/8/2n5/1n6/8/8/8/k6N w - - 0 1", { 3, 51, 345, 5301, 38348, 588695 } },
+        { "k7/8/2N5/1N6/8/8/8/K6n w - - 0 1", { 17, 54, 835, 5910, 92250, 688780 } },
+        { "8/1n4N1/2k5/8/8/5K2/1N4n1/8 b - - 0 1", { 15, 193, 2816, 40039, 582642, 8503277 } },
+        { "8/1k6/8/5N2/8/4n3/8/2K5 b - - 0 1", { 16, 180, 2290, 24640, 288141, 3147566 } },
+        { "8/8/3K4/3Nn3/3nN3/4k3/8/8 b - - 0 1", { 4, 68, 1118, 16199, 281190, 4405103 } },
+        { "K7/8/2n5/1n6/8/8/8/k6N b - - 0 1", { 17, 54, 835, 5910, 92250, 688780 } },
+        { "k7/8/2N5/1N6/8/8/8/K6n b - - 0 1", { 3, 51, 345, 5301, 38348, 588695 } },
+
+        // bishops
+        { "B6b/8/8/8/2K5/4k3/8/b6B w - - 0 1", { 17, 278, 4607, 76778, 1320507, 22823890 } },
+        { "8/8/1B6/7b/7k/8/2B1b3/7K w - - 0 1", { 21, 316, 5744, 93338, 1713368, 28861171 } },
+        { "k7/B7/1B6/1B6/8/8/8/K6b w - - 0 1", { 21, 144, 3242, 32955, 787524, 7881673 } },
+        { "K7/b7/1b6/1b6/8/8/8/k6B w - - 0 1", { 7, 143, 1416, 31787, 310862, 7382896 } },
+        { "B6b/8/8/8/2K5/5k2/8/b6B b - - 0 1", { 6, 106, 1829, 31151, 530585, 9250746 } },
+        { "8/8/1B6/7b/7k/8/2B1b3/7K b - - 0 1", { 17, 309, 5133, 93603, 1591064, 29027891 } },
+        { "k7/B7/1B6/1B6/8/8/8/K6b b - - 0 1", { 7, 143, 1416, 31787, 310862, 7382896 } },
+        { "K7/b7/1b6/1b6/8/8/8/k6B b - - 0 1", { 21, 144, 3242, 32955, 787524, 7881673 } },
+
+        // rooks
+        { "7k/RR6/8/8/8/8/rr6/7K w - - 0 1", { 19, 275, 5300, 104342, 2161211, 44956585 } },
+        { "R6r/8/8/2K5/5k2/8/8/r6R w - - 0 1", { 36, 1027, 29215, 771461, 20506480 } },
+        { "7k/RR6/8/8/8/8/rr6/7K b - - 0 1", { 19, 275, 5300, 104342, 2161211, 44956585 } },
+        { "R6r/8/8/2K5/5k2/8/8/r6R b - - 0 1", { 36, 1027, 29227, 771368, 20521342 } },
+
+        // queens
+        { "6kq/8/8/8/8/8/8/7K w - - 0 1", { 2, 36, 143, 3637, 14893, 391507 } },
+        { "6KQ/8/8/8/8/8/8/7k b - - 0 1", { 2, 36, 143, 3637, 14893, 391507 } },
+        { "K7/8/8/3Q4/4q3/8/8/7k w - - 0 1", { 6, 35, 495, 8349, 166741, 3370175 } },
+        { "6qk/8/8/8/8/8/8/7K b - - 0 1", { 22, 43, 1015, 4167, 105749, 419369 } },
+        { "K7/8/8/3Q4/4q3/8/8/7k b - - 0 1", { 6, 35, 495, 8349, 166741, 3370175 } },
+
+        // pawns
+        { "8/8/8/8/8/K7/P7/k7 w - - 0 1", { 3, 7, 43, 199, 1347, 6249 } },
+        { "8/8/8/8/8/7K/7P/7k w - - 0 1", { 3, 7, 43, 199, 1347, 6249 } },
+        { "K7/p7/k7/8/8/8/8/8 w - - 0 1", { 1, 3, 12, 80, 342, 2343 } },
+        { "7K/7p/7k/8/8/8/8/8 w - - 0 1", { 1, 3, 12, 80, 342, 2343 } },
+        { "8/2k1p3/3pP3/3P2K1/8/8/8/8 w - - 0 1", { 7, 35, 210, 1091, 7028, 34834 } },
+        { "8/8/8/8/8/K7/P7/k7 b - - 0 1", { 1, 3, 12, 80, 342, 2343 } },
+        { "8/8/8/8/8/7K/7P/7k b - - 0 1", { 1, 3, 12, 80, 342, 2343 } },
+        { "K7/p7/k7/8/8/8/8/8 b - - 0 1", { 3, 7, 43, 199, 1347, 6249 } },
+        { "7K/7p/7k/8/8/8/8/8 b - - 0 1", { 3, 7, 43, 199, 1347, 6249 } },
+        { "8/2k1p3/3pP3/3P2K1/8/8/8/8 b - - 0 1", { 5, 35, 182, 1091, 5408, 34822 } },
+        { "8/8/8/8/8/4k3/4P3/4K3 w - - 0 1", { 2, 8, 44, 282, 1814, 11848 } },
+        { "4k3/4p3/4K3/8/8/8/8/8 b - - 0 1", { 2, 8, 44, 282, 1814, 11848 } },
+        { "8/8/7k/7p/7P/7K/8/8 w - - 0 1", { 3, 9, 57, 360, 1969, 10724 } },
+        { "8/8/k7/p7/P7/K7/8/8 w - - 0 1", { 3, 9, 57, 360, 1969, 10724 } },
+        { "8/8/3k4/3p4/3P4/3K4/8/8 w - - 0 1", { 5, 25, 180, 1294, 8296, 53138 } },
+        { "8/3k4/3p4/8/3P4/3K4/8/8 w - - 0 1", { 8, 61, 483, 3213, 23599, 157093 } },
+        { "8/8/3k4/3p4/8/3P4/3K4/8 w - - 0 1", { 8, 61, 411, 3213, 21637, 158065 } },
+        { "k7/8/3p4/8/3P4/8/8/7K w - - 0 1", { 4, 15, 90, 534, 3450, 20960 } },
+        { "8/8/7k/7p/7P/7K/8/8 b - - 0 1", { 3, 9, 57, 360, 1969, 10724 } },
+        { "8/8/k7/p7/P7/K7/8/8 b - - 0 1", { 3, 9, 57, 360, 1969, 10724 } },
+        { "8/8/3k4/3p4/3P4/3K4/8/8 b - - 0 1", { 5, 25, 180, 1294, 8296, 53138 } },
+        { "8/3k4/3p4/8/3P4/3K4/8/8 b - - 0 1", { 8, 61, 411, 3213, 21637, 158065 } },
+        { "8/8/3k4/3p4/8/3P4/3K4/8 b - - 0 1", { 8, 61, 483, 3213, 23599, 157093 } },
+        { "k7/8/3p4/8/3P4/8/8/7K b - - 0 1", { 4, 15, 89, 537, 3309, 21104 } },
+        { "7k/3p4/8/8/3P4/8/8/K7 w - - 0 1", { 4, 19, 117, 720, 4661, 32191 } },
+        { "7k/8/8/3p4/8/8/3P4/K7 w - - 0 1", { 5, 19, 116, 716, 4786, 30980 } },
+        { "k7/8/8/7p/6P1/8/8/K7 w - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "k7/8/7p/8/8/6P1/8/K7 w - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "k7/8/8/6p1/7P/8/8/K7 w - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "k7/8/6p1/8/8/7P/8/K7 w - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "k7/8/8/3p4/4p3/8/8/7K w - - 0 1", { 3, 15, 84, 573, 3013, 22886 } },
+        { "k7/8/3p4/8/8/4P3/8/7K w - - 0 1", { 4, 16, 101, 637, 4271, 28662 } },
+        { "7k/3p4/8/8/3P4/8/8/K7 b - - 0 1", { 5, 19, 117, 720, 5014, 32167 } },
+        { "7k/8/8/3p4/8/8/3P4/K7 b - - 0 1", { 4, 19, 117, 712, 4658, 30749 } },
+        { "k7/8/8/7p/6P1/8/8/K7 b - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "k7/8/7p/8/8/6P1/8/K7 b - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "k7/8/8/6p1/7P/8/8/K7 b - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "k7/8/6p1/8/8/7P/8/K7 b - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "k7/8/8/3p4/4p3/8/8/7K b - - 0 1", { 5, 15, 102, 569, 4337, 22579 } },
+        { "k7/8/3p4/8/8/4P3/8/7K b - - 0 1", { 4, 16, 101, 637, 4271, 28662 } },
+        { "7k/8/8/p7/1P6/8/8/7K w - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "7k/8/p7/8/8/1P6/8/7K w - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "7k/8/8/1p6/P7/8/8/7K w - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "7k/8/1p6/8/8/P7/8/7K w - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "k7/7p/8/8/8/8/6P1/K7 w - - 0 1", { 5, 25, 161, 1035, 7574, 55338 } },
+        { "k7/6p1/8/8/8/8/7P/K7 w - - 0 1", { 5, 25, 161, 1035, 7574, 55338 } },
+        { "3k4/3pp3/8/8/8/8/3PP3/3K4 w - - 0 1", { 7, 49, 378, 2902, 24122, 199002 } },
+        { "7k/8/8/p7/1P6/8/8/7K b - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "7k/8/p7/8/8/1P6/8/7K b - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "7k/8/8/1p6/P7/8/8/7K b - - 0 1", { 5, 22, 139, 877, 6112, 41874 } },
+        { "7k/8/1p6/8/8/P7/8/7K b - - 0 1", { 4, 16, 101, 637, 4354, 29679 } },
+        { "k7/7p/8/8/8/8/6P1/K7 b - - 0 1", { 5, 25, 161, 1035, 7574, 55338 } },
+        { "k7/6p1/8/8/8/8/7P/K7 b - - 0 1", { 5, 25, 161, 1035, 7574, 55338 } },
+        { "3k4/3pp3/8/8/8/8/3PP3/3K4 b - - 0 1", { 7, 49, 378, 2902, 24122, 199002 } },
+
+        // promotions
+        { "8/Pk6/8/8/8/8/6Kp/8 w - - 0 1", { 11, 97, 887, 8048, 90606, 1030499 } },
+        { "n1n5/1Pk5/8/8/8/8/5Kp1/5N1N w - - 0 1", { 24, 421, 7421, 124608, 2193768, 37665329 } },
+        { "8/PPPk4/8/8/8/8/4Kppp/8 w - - 0 1", { 18, 270, 4699, 79355, 1533145, 28859283 } },
+        { "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N w - - 0 1", { 24, 496, 9483, 182838, 3605103, 71179139 } },
+        { "8/Pk6/8/8/8/8/6Kp/8 b - - 0 1", { 11, 97, 887, 8048, 90606, 1030499 } },
+        { "n1n5/1Pk5/8/8/8/8/5Kp1/5N1N b - - 0 1", { 24, 421, 7421, 124608, 2193768, 37665329 } },
+        { "8/PPPk4/8/8/8/8/4Kppp/8 b - - 0 1", { 18, 270, 4699, 79355, 1533145, 28859283 } },
+        { "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", { 24, 496, 9483, 182838, 3605103, 71179139 } },
+    };
+
+    // perft suite: node counts against reference counts (up to given depth), nodes, time & speed
+    void perft_suite_bench(int max_depth)
+    {
+        std::cout << "\n     Perft suite\n\n";
+
+        // number of suite positions
+        int suite_count = sizeof(perft_suite) / sizeof(perft_suite[0]);
+
+        // totals
+        long long total_nodes = 0, total_us = 0;
+        int passed = 0;
+
+        // loop over suite positions
+        for (int index = 0; index < suite_count; index++)
         {
-            if (Time::stopped)
-                break;
+            // init position
+            parse_fen(pos, perft_suite[index].fen);
 
-            follow_pv = true;
+            // position nodes & time
+            long long position_nodes = 0;
+            int failed = 0;
 
-            // find best move within a given position
-            score = negamax(alpha, beta, current_depth);
+            auto start = std::chrono::steady_clock::now();
 
-            // we fell outside the window, so try again with a full-width window (and the same depth)
-            if ((score <= alpha) || (score >= beta)) {
-                alpha = -infinity;
-                beta = infinity;
-                continue;
+            // loop over depths listed in the suite
+            for (int depth = 1; depth <= 6 && depth <= max_depth && perft_suite[index].nodes[depth - 1]; depth++)
+            {
+                // run perft
+                Perft::nodes = 0;
+                Perft::perft_driver(pos, depth);
+                position_nodes += Perft::nodes;
+
+                // compare against reference count
+                if (Perft::nodes != perft_suite[index].nodes[depth - 1])
+                {
+                    printf("     position %d depth %d: %lld nodes, expected %lld\n", index + 1, depth, Perft::nodes, perft_suite[index].nodes[depth - 1]);
+                    failed = 1;
+                }
             }
 
-            // set up the window for the next iteration
-            alpha = score - 50;
-            beta = score + 50;
+            long long us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
 
-            if (score > -mate_value && score < -mate_score)
-                printf("info score mate %d depth %d nodes %ld time %d pv ", -(score + mate_value) / 2 - 1, current_depth, Perft::nodes, Time::get_time_ms() - Time::starttime);
+            // print results
+            printf("     %3d %s  nodes: %lld  time: %lld ms  nps: %lld  %s\n", index + 1, failed ? "FAIL" : "pass",
+                position_nodes, us / 1000, us ? position_nodes * 1000000 / us : 0, perft_suite[index].fen);
 
-            else if (score > mate_score && score < mate_value)
-                printf("info score mate %d depth %d nodes %ld time %d pv ", (mate_value - score) / 2 + 1, current_depth, Perft::nodes, Time::get_time_ms() - Time::starttime);
+            // update totals
+            passed += !failed;
+            total_nodes += position_nodes;
+            total_us += us;
+        }
 
-            else
-                printf("info score cp %d depth %d nodes %ld time %d pv ", score, current_depth, Perft::nodes, Time::get_time_ms() - Time::starttime);
+        // print summary
+        printf("\n     Passed: %d/%d  %s\n", passed, suite_count, passed == suite_count ? "OK" : "FAILED");
+        printf("     Total nodes: %lld  time: %lld ms  nps: %lld\n\n", total_nodes, total_us / 1000, total_us ? total_nodes * 1000000 / total_us : 0);
+    }
 
-            
+    // compare TT in large & normal pages: dependent random bucket probes (TLB misses dominate on large tables) & search speed
+    void large_pages_bench(int megabytes)
+    {
+        std::cout << "\n     Large pages bench\n\n";
 
-            // loop over the moves within a PV line
-            for (int count = 0; count < pv_length[0]; count++)
+        // number of random probes & search depth
+        const long probes = 10000000;
+        const int depth = 6;
+
+        // TT size & page setting to restore
+        int previous_megabytes = Search::hash_megabytes;
+        int previous_large_pages = Search::use_large_pages;
+
+        // large pages first, then normal pages
+        for (int mode = 1; mode >= 0; mode--)
+        {
+            // allocate TT (reports the kind of pages it got)
+            printf("     %s requested: ", mode ? "large pages" : "normal pages");
+            Search::use_large_pages = mode;
+            Search::init_hash_table(megabytes);
+
+            // map all pages before timing
+            Search::clear_hash_table();
+
+            // memory actually backed by huge pages (-1 if not reported)
+            long huge_pages_kb = Search::anon_huge_pages_kb();
+
+            // each probe depends on the previous one (table is empty, so keys stay random)
+            U64 state = 0x9E3779B97F4A7C15ULL, entry_key = 0;
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (long probe = 0; probe < probes; probe++)
+                entry_key += Search::get_hash_bucket(Zobrist::get_random_key(state) ^ entry_key)->entries[0].key;
+
+            double probe_time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+            // search bench positions
+            long long nodes = 0;
+            long time = 0;
+
+            for (int index = 0; index < 4; index++)
             {
-                // print PV move
-                MoveGeneration::print_move(pv_table[0][count]);
-                printf(" ");
+                parse_fen(pos, positions[index]);
+
+                long search_start = Time::get_time_ms();
+                Search::search_position(pos, depth);
+                time += Time::get_time_ms() - search_start;
+                nodes += Perft::nodes;
             }
 
-            // print new line
+            printf("\n     %s: %.1f ns per probe  search nodes: %lld  time: %ld ms  nps: %lld%s\n",
+                Search::page_kind_names[Search::hash_memory_kind], probe_time / probes, nodes, time, time ? nodes * 1000 / time : 0,
+                entry_key ? " (TT not empty)" : "");
+
+            if (huge_pages_kb >= 0)
+                printf("     anonymous memory in huge pages: %ld MB of %d MB TT\n", huge_pages_kb / 1024, megabytes);
+
             printf("\n");
         }
 
-        // best move placeholder
-        printf("bestmove ");
-        MoveGeneration::print_move(pv_table[0][0]);
-        printf("\n");
+        // restore TT
+        Search::use_large_pages = previous_large_pages;
+        Search::init_hash_table(previous_megabytes);
+        std::cout << "\n";
+    }
+
+    // time engine start up (tables are generated at compile time, so only run time init is left,
+    // slider tables are generated at start up unless CONSTEXPR_SLIDERS is set)
+    void startup_bench()
+    {
+        std::cout << "\n     Startup bench\n\n";
+
+        // number of init runs
+        const int runs = 1000;
+
+        auto start = std::chrono::steady_clock::now();
+
+        // init engine
+        for (int run = 0; run < runs; run++)
+            init_all();
+
+        double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        // read-only tables size
+        long tables_size = (long)(sizeof(Attacks::leaper_tables) + sizeof(Attacks::line_tables) +
+            sizeof(Zobrist::random_keys) + sizeof(Evaluation::evaluation_masks));
 
+        // slider tables size
+        long slider_tables_size = (long)sizeof(Attacks::slider_tables);
 
+#if USE_PEXT
+        slider_tables_size += (long)sizeof(Attacks::pext_slider_tables);
+#endif
+
+#if CONSTEXPR_SLIDERS
+        tables_size += slider_tables_size;
+#else
+        printf("     start up slider tables: %ld KB\n", slider_tables_size / 1024);
+#endif
+
+        printf("     compile time tables: %ld KB (read-only data)\n", tables_size / 1024);
+        printf("     init_all: %.3f us per call\n\n", time / runs);
     }
+}
+
+// count heap allocations for the allocation bench
+void* operator new(size_t size)
+{
+    // count allocation (only while allocation bench is running)
+    if (Bench::count_allocations.load(std::memory_order_relaxed))
+        Bench::allocations.fetch_add(1, std::memory_order_relaxed);
 
+    // allocate memory
+    void* memory = malloc(size ? size : 1);
+
+    // out of memory
+    if (memory == NULL)
+        throw std::bad_alloc();
+
+    return memory;
+}
+
+// release memory allocated by the counting operator new
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+// release memory allocated by the counting operator new (sized version)
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
 }
 
 namespace UCI
 {
+    // game position (the one GUI sets up & engine searches)
+    Position pos;
+
     // parse user/GUI move string input (e.g. "e7e8q")
-    int parse_move(char* move_string)
+    int parse_move(const Position& pos, char* move_string)
     {
         // create move list instance
-        std::vector<int> move_list;
+        MoveGeneration::MoveList move_list;
 
         // generate moves
-        MoveGeneration::generate_moves(move_list);
+        MoveGeneration::generate_moves(pos, move_list);
 
         // parse source square
         int source_square = (move_string[0] - 'a') + (8 - (move_string[1] - '0')) * 8;
@@ -1671,10 +3635,10 @@ namespace UCI
         int target_square = (move_string[2] - 'a') + (8 - (move_string[3] - '0')) * 8;
 
         // loop over the moves within a move list
-        for (int move_count = 0; move_count < move_list.size(); move_count++)
+        for (int move_count = 0; move_count < move_list.count; move_count++)
         {
             // init move
-            int move = move_list[move_count];
+            int move = move_list.moves[move_count];
 
             // make sure source & target squares are available within the generated move
             if (source_square == get_move_source(move) && target_square == get_move_target(move))
@@ -1735,7 +3699,7 @@ namespace UCI
     */
 
     // parse UCI "position" command
-    void parse_position(char* command)
+    void parse_position(Position& pos, char* command)
     {
         // shift pointer to the right where next token begins
         command += 9;
@@ -1746,7 +3710,7 @@ namespace UCI
         // parse UCI "startpos" command
         if (strncmp(command, "startpos", 8) == 0)
             // init chess board with start position
-            parse_fen(start_position);
+            parse_fen(pos, start_position);
 
         // parse UCI "fen" command 
         else
@@ -1757,7 +3721,7 @@ namespace UCI
             // if no "fen" command is available within command string
             if (current_char == NULL)
                 // init chess board with start position
-                parse_fen(start_position);
+                parse_fen(pos, start_position);
 
             // found "fen" substring
             else
@@ -1766,7 +3730,7 @@ namespace UCI
                 current_char += 4;
 
                 // init chess board with position from FEN string
-                parse_fen(current_char);
+                parse_fen(pos, current_char);
             }
         }
 
@@ -1783,15 +3747,16 @@ namespace UCI
             while (*current_char)
             {
                 // parse next move
-                int move = parse_move(current_char);
+                int move = parse_move(pos, current_char);
 
                 // if no more moves
                 if (move == 0)
                     // break out of the loop
                     break;
 
-                // make move on the chess board
-                MoveGeneration::make_move(move, MoveGeneration::all_moves);
+                // make move on the chess board (it's never taken back)
+                MoveGeneration::Undo undo;
+                MoveGeneration::make_move(pos, move, undo);
 
                 // move current character mointer to the end of current move
                 while (*current_char && *current_char != ' ') current_char++;
@@ -1802,11 +3767,11 @@ namespace UCI
         }
 
         // print board
-        print_board();
+        print_board(pos);
     }
 
     // parse UCI command "go"
-    void parse_go(char* command)
+    void parse_go(Position& pos, char* command)
     {
         // init parameters
         int depth = -1;
@@ -1814,26 +3779,34 @@ namespace UCI
         // init argument
         char* argument = NULL;
 
+        // match "go perft" command (perft divide instead of search)
+        if ((argument = strstr(command, "perft")))
+        {
+            // perft divide to given depth (at least 1)
+            Perft::perft_divide(pos, atoi(argument + 5) > 0 ? atoi(argument + 5) : 1);
+            return;
+        }
+
         // infinite search
         if ((argument = strstr(command, "infinite"))) {}
 
         // match UCI "binc" command
-        if ((argument = strstr(command, "binc")) && side == black)
+        if ((argument = strstr(command, "binc")) && pos.side == black)
             // parse black time increment
             Time::inc = atoi(argument + 5);
 
         // match UCI "winc" command
-        if ((argument = strstr(command, "winc")) && side == white)
+        if ((argument = strstr(command, "winc")) && pos.side == white)
             // parse white time increment
             Time::inc = atoi(argument + 5);
 
         // match UCI "wtime" command
-        if ((argument = strstr(command, "wtime")) && side == white)
+        if ((argument = strstr(command, "wtime")) && pos.side == white)
             // parse white time limit
             Time::time = atoi(argument + 6);
 
         // match UCI "btime" command
-        if ((argument = strstr(command, "btime")) && side == black)
+        if ((argument = strstr(command, "btime")) && pos.side == black)
             // parse black time limit
             Time::time = atoi(argument + 6);
 
@@ -1893,7 +3866,266 @@ namespace UCI
             Time::time, Time::starttime, Time::stoptime, depth, Time::timeset);
 
         // search position
-        Search::search_position(depth);
+        Search::search_position(pos, depth);
+    }
+
+    /*
+        Example UCI setoption commands
+
+        // resize hash table to 1 GB
+        setoption name Hash value 1024
+
+        // make every leaf move in perft (count leaves by making them)
+        setoption name BulkCount value false
+        setoption name PerftHash value 64
+        setoption name PerftVerify value true
+    */
+
+    // parse UCI "setoption" command
+    void parse_setoption(char* command)
+    {
+        // init argument
+        char* argument = NULL;
+
+        // match "Hash" option
+        if (strstr(command, "name Hash") && (argument = strstr(command, "value")))
+        {
+            // resize & clear hash table
+            Search::init_hash_table(atoi(argument + 6));
+        }
+
+        // match "BulkCount" option
+        else if (strstr(command, "name BulkCount") && (argument = strstr(command, "value")))
+        {
+            // count perft leaves by the number of legal moves (or by making them)
+            Perft::bulk_counting = strstr(argument + 6, "true") != NULL;
+            printf("info string perft bulk counting: %s\n", Perft::bulk_counting ? "on" : "off");
+        }
+
+        // match "PerftHash" option
+        else if (strstr(command, "name PerftHash") && (argument = strstr(command, "value")))
+        {
+            // (re)allocate perft hash table (0 disables hashing)
+            Perft::init_perft_hash(atoi(argument + 6));
+            printf("info string perft hash: %d MB\n", Perft::perft_hash_entries ? atoi(argument + 6) : 0);
+        }
+
+        // match "PerftVerify" option
+        else if (strstr(command, "name PerftVerify") && (argument = strstr(command, "value")))
+        {
+            // rerun hashed perft divide without the hash & compare node counts
+            Perft::verify_hash = strstr(argument + 6, "true") != NULL;
+            printf("info string perft hash verification: %s\n", Perft::verify_hash ? "on" : "off");
+        }
+    }
+
+    /*
+        Example perft commands
+
+        // perft divide of current position
+        go perft 5
+
+        // run EPD file positions (FEN ;D1 20 ;D2 400 ...) up to given (or all) depth
+        perft epd perftsuite.epd 5
+    */
+
+    // parse "perft epd" command (streams EPD file, positions run on all threads,
+    // prints one result line per position: pass, fail or invalid)
+    void parse_perft(char* command)
+    {
+        // init argument
+        char* argument = strstr(command, "epd");
+
+        // no EPD file given
+        if (argument == NULL)
+        {
+            printf("info string usage: perft epd <file> [depth]\n");
+            return;
+        }
+
+        // skip spaces up to file path
+        argument += 3;
+        while (*argument == ' ') argument++;
+
+        // file path ends at space or new line
+        std::string path;
+        while (*argument && *argument != ' ' && *argument != '\n' && *argument != '\r')
+            path += *argument++;
+
+        // max depth to run (all depths by default)
+        int max_depth = atoi(argument) > 0 ? atoi(argument) : MAX_PLY;
+
+        // open EPD file
+        std::ifstream epd(path);
+
+        if (!epd)
+        {
+            printf("info string perft epd: can't open %s\n", path.c_str());
+            return;
+        }
+
+        // threads & root moves
+        int threads = Perft::perft_threads();
+        MoveGeneration::MoveList root_moves;
+
+        // totals
+        int positions = 0, passed = 0;
+        long long total_nodes = 0;
+        long start = Time::get_time_ms();
+
+        // read EPD file line by line
+        std::string line;
+        int line_number = 0;
+
+        while (std::getline(epd, line))
+        {
+            line_number++;
+
+            // FEN ends at the first operation separator
+            size_t separator = line.find(';');
+            std::string fen = line.substr(0, separator);
+
+            // skip empty lines
+            if (fen.find_first_not_of(" \t\r") == std::string::npos)
+                continue;
+
+            // init position (bench position keeps the game position intact)
+            parse_fen(Bench::pos, fen.c_str());
+
+            // move generation needs one king per side, report broken positions as failed
+            if (count_bits(Bench::pos.bitboards[K]) != 1 || count_bits(Bench::pos.bitboards[k]) != 1)
+            {
+                printf("info string perft epd line %d result invalid depths 0 nodes 0\n", line_number);
+                fflush(stdout);
+
+                positions++;
+                continue;
+            }
+
+            // position nodes & result
+            long long position_nodes = 0;
+            int failed = 0, depths = 0;
+
+            // loop over ";D<depth> <nodes>" operations
+            while (separator != std::string::npos)
+            {
+                // parse depth & expected node count
+                const char* operation = line.c_str() + separator + 1;
+                while (*operation == ' ') operation++;
+
+                separator = line.find(';', separator + 1);
+
+                if (*operation != 'D')
+                    continue;
+
+                char* end = NULL;
+                int depth = (int)strtol(operation + 1, &end, 10);
+                long long expected = strtoll(end, NULL, 10);
+
+                if (depth < 1 || depth > max_depth)
+                    continue;
+
+                // run perft on all threads
+                long long nodes = Perft::parallel_perft(Bench::pos, depth, threads, root_moves);
+                position_nodes += nodes;
+                depths++;
+
+                // report wrong node count
+                if (nodes != expected)
+                {
+                    printf("info string perft epd line %d depth %d nodes %lld expected %lld\n", line_number, depth, nodes, expected);
+                    failed = 1;
+                }
+            }
+
+            // print position result
+            printf("info string perft epd line %d result %s depths %d nodes %lld\n", line_number, failed ? "fail" : "pass", depths, position_nodes);
+            fflush(stdout);
+
+            // update totals
+            positions++;
+            passed += !failed;
+            total_nodes += position_nodes;
+        }
+
+        long time = Time::get_time_ms() - start;
+
+        // print summary
+        printf("info string perft epd positions %d passed %d failed %d nodes %lld time %ld nps %lld threads %d bulk %s hash %s\n",
+            positions, passed, positions - passed, total_nodes, time, time ? total_nodes * 1000 / time : 0, threads,
+            Perft::bulk_counting ? "on" : "off", Perft::perft_hash_entries ? "on" : "off");
+    }
+
+    /*
+        Example bench commands
+
+        // make sure perft & search don't allocate (default depth 4)
+        bench alloc 5
+
+        // compare 1 GB TT in large & normal pages (default size 1024 MB)
+        bench largepages 1024
+    */
+
+    // parse "bench" command
+    void parse_bench(char* command)
+    {
+        // init argument
+        char* argument = NULL;
+
+        // match allocation bench
+        if ((argument = strstr(command, "alloc")))
+            // run allocation bench with given (or default) depth
+            Bench::allocation_bench(atoi(argument + 5) > 0 ? atoi(argument + 5) : 4);
+
+        // match bit primitives bench
+        else if (strstr(command, "bits"))
+            // run bit primitives bench
+            Bench::bit_bench();
+
+        // match slider attacks bench
+        else if (strstr(command, "attacks"))
+            // run slider attacks bench
+            Bench::attack_bench();
+
+        // match startup bench
+        else if (strstr(command, "startup"))
+            // run startup bench
+            Bench::startup_bench();
+
+        // match large pages bench
+        else if ((argument = strstr(command, "largepages")))
+            // run large pages bench with given (or default) TT size in MB
+            Bench::large_pages_bench(atoi(argument + 10) > 0 ? atoi(argument + 10) : 1024);
+
+        // match search bench
+        else if ((argument = strstr(command, "search")))
+            // run search bench with given (or default) depth
+            Bench::search_bench(atoi(argument + 6) > 0 ? atoi(argument + 6) : 6);
+
+        // match move generation bench
+        else if ((argument = strstr(command, "movegen")))
+            // run move generation bench with given (or default) depth
+            Bench::movegen_bench(atoi(argument + 7) > 0 ? atoi(argument + 7) : 5);
+
+        // match perft hash bench
+        else if ((argument = strstr(command, "perfthash")))
+            // run perft hash bench with given (or default) depth
+            Bench::perft_hash_bench(atoi(argument + 9) > 0 ? atoi(argument + 9) : 5);
+
+        // match perft suite (after perft hash bench, "perft" is a part of "perfthash")
+        else if ((argument = strstr(command, "perft")))
+            // run perft suite up to given (or all) depth
+            Bench::perft_suite_bench(atoi(argument + 5) > 0 ? atoi(argument + 5) : 6);
+
+        // match parallel perft bench
+        else if ((argument = strstr(command, "threads")))
+            // run parallel perft bench with given (or default) depth
+            Bench::perft_threads_bench(atoi(argument + 7) > 0 ? atoi(argument + 7) : 5);
+
+        // match make/unmake bench
+        else if ((argument = strstr(command, "makemove")))
+            // run make/unmake bench with given (or default) depth
+            Bench::make_move_bench(atoi(argument + 8) > 0 ? atoi(argument + 8) : 5);
     }
 
     // main UCI loop
@@ -1909,8 +4141,15 @@ namespace UCI
         // print engine info
         printf("id name BBC\n");
         printf("id name Lencho\n");
+        printf("option name Hash type spin default %d min 1 max %d\n", default_hash_mb, max_hash_mb);
+        printf("option name BulkCount type check default true\n");
+        printf("option name PerftHash type spin default 0 min 0 max %d\n", max_hash_mb);
+        printf("option name PerftVerify type check default false\n");
         printf("uciok\n");
 
+        // print slider attacks backend
+        printf("info string slider attacks: %s\n", Attacks::pext_enabled ? "pext" : "magic");
+
         // main loop
         while (1)
         {
@@ -1940,17 +4179,37 @@ namespace UCI
             // parse UCI "position" command
             else if (strncmp(input, "position", 8) == 0)
                 // call parse position function
-                parse_position(input);
+                parse_position(pos, input);
 
             // parse UCI "ucinewgame" command
             else if (strncmp(input, "ucinewgame", 10) == 0)
+            {
                 // call parse position function
-                parse_position((char*)start_position);
+                parse_position(pos, (char*)start_position);
+
+                // forget previous game
+                Search::clear_hash_table();
+            }
+
+            // parse UCI "setoption" command
+            else if (strncmp(input, "setoption", 9) == 0)
+                // call parse setoption function
+                parse_setoption(input);
 
             // parse UCI "go" command
             else if (strncmp(input, "go", 2) == 0)
                 // call parse go function
-                parse_go(input);
+                parse_go(pos, input);
+
+            // parse "bench" command
+            else if (strncmp(input, "bench", 5) == 0)
+                // call parse bench function
+                parse_bench(input);
+
+            // parse "perft" command
+            else if (strncmp(input, "perft", 5) == 0)
+                // call parse perft function
+                parse_perft(input);
 
             // parse UCI "quit" command
             else if (strncmp(input, "quit", 4) == 0)
@@ -1963,6 +4222,10 @@ namespace UCI
                 // print engine info
                 printf("id name BBC\n");
                 printf("id name Lencho\n");
+                printf("option name Hash type spin default %d min 1 max %d\n", default_hash_mb, max_hash_mb);
+                printf("option name BulkCount type check default true\n");
+                printf("option name PerftHash type spin default 0 min 0 max %d\n", max_hash_mb);
+                printf("option name PerftVerify type check default false\n");
                 printf("uciok\n");
             }
         }
@@ -1970,27 +4233,17 @@ namespace UCI
 }
 
 
-void init_all()
-{
-    init_leapers_attacks();
-    init_sliders_attacks(bishop);
-    init_sliders_attacks(rook);
-    Zobrist::init_random_keys();
-    Evaluation::init_evaluation_masks();
-    Search::clear_hash_table();
-}
 
 
 
 int main()
 {
 
-    init_all;
+    init_all();
 
-    parse_fen(tricky_position);
+    // init start position ("position" command sets up any other one)
+    parse_fen(UCI::pos, start_position);
 
-    print_board();
-    Search::search_position(4);
     // connect to the GUI
     UCI::uci_loop();
 
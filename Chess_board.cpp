@@ -102,7 +102,7 @@ void print_bitboard(U64& bitboard)
 
 
 // print board
-void print_board()
+void print_board(const Position& pos)
 {
     // print offset
     std::cout << "\n";
@@ -120,19 +120,10 @@ void print_board()
             if (!file)
                 std::cout<< 8 - rank<<"  ";
 
-            // define piece variable
-            int piece = -1;
+            // get piece code
+            int piece = pos.piece_on[square];
 
-            // loop over all piece bitboards
-            for (int bb_piece = P; bb_piece <= k; bb_piece++)
-            {
-                // if there is a piece on current square
-                if (get_bit(bitboards[bb_piece], square))
-                    // get piece code
-                    piece = bb_piece;
-            }
-
-            std::cout<< ((piece == -1) ? '.' : ascii_pieces[piece])<<" ";
+            std::cout<< ((piece == no_piece) ? '.' : ascii_pieces[piece])<<" ";
 
         }
 
@@ -143,41 +134,46 @@ void print_board()
     std::cout<<"\n   a b c d e f g h\n\n";
 
     // print side to move
-    std::cout<<"    Side:     "<< (!side ? "white\n" : "black\n");
+    std::cout<<"    Side:     "<< (!pos.side ? "white\n" : "black\n");
 
     // print enpassant square
-    std::cout<<"    Enpassant:   "<< ((enpassant != no_sq) ? square_to_coordinates[enpassant] : "no")<<"\n";
+    std::cout<<"    Enpassant:   "<< ((pos.enpassant != no_sq) ? square_to_coordinates[pos.enpassant] : "no")<<"\n";
 
     // print castling rights
-    printf("    Castling:  %c%c%c%c\n\n", (castle & wk) ? 'K' : '-',
-                                           (castle & wq) ? 'Q' : '-',
-                                           (castle & bk) ? 'k' : '-',
-                                           (castle & bq) ? 'q' : '-');
+    printf("    Castling:  %c%c%c%c\n\n", (pos.castle & wk) ? 'K' : '-',
+                                           (pos.castle & wq) ? 'Q' : '-',
+                                           (pos.castle & bk) ? 'k' : '-',
+                                           (pos.castle & bq) ? 'q' : '-');
     // print hash key
-    printf("     Hash key:  %llx\n\n", hash_key);
+    printf("     Hash key:  %llx\n\n", pos.hash_key);
 }
 
 // parse FEN string
-void parse_fen(const char* fen)
+void parse_fen(Position& pos, const char* fen)
 {
     // reset board position (bitboards)
-    memset(bitboards, 0ULL, sizeof(bitboards));
+    memset(pos.bitboards, 0ULL, sizeof(pos.bitboards));
 
     // reset occupancies (bitboards)
-    memset(occupancies, 0ULL, sizeof(occupancies));
+    memset(pos.occupancies, 0ULL, sizeof(pos.occupancies));
+
+    // reset pieces by square
+    for (int square = 0; square < 64; square++)
+        pos.piece_on[square] = no_piece;
 
     // reset game state variables
-    side = 0;
-    enpassant = no_sq;
-    castle = 0;
+    pos.side = 0;
+    pos.enpassant = no_sq;
+    pos.castle = 0;
 
     // reset repetition index
-    repetition_index = 0;
+    pos.repetition_index = 0;
 
     // reset repetition table
-    memset(repetition_table, 0ULL, sizeof(repetition_table));
+    memset(pos.repetition_table, 0ULL, sizeof(pos.repetition_table));
 
-    printf("ply: %d\n", ply);
+    // reset half move counter
+    pos.ply = 0;
 
     // loop over board ranks and files
     for (int rank = 0; rank < 8; rank++)
@@ -196,7 +192,10 @@ void parse_fen(const char* fen)
 
 
                 // set piece on corresponding bitboard
-                set_bit(bitboards[piece], square);
+                set_bit(pos.bitboards[piece], square);
+
+                // set piece on the square
+                pos.piece_on[square] = piece;
 
                 // increment pointer to FEN string
                 fen++;
@@ -215,7 +214,7 @@ void parse_fen(const char* fen)
                 for (int bb_piece = P; bb_piece <= k; bb_piece++)
                 {
                     // if there is a piece on current square
-                    if (get_bit(bitboards[bb_piece], square))
+                    if (get_bit(pos.bitboards[bb_piece], square))
                         // get piece code
                         piece = bb_piece;
                 }
@@ -241,7 +240,7 @@ void parse_fen(const char* fen)
     fen++;
 
     // parse side to move
-    (*fen == 'w') ? (side = white) : (side = black);
+    (*fen == 'w') ? (pos.side = white) : (pos.side = black);
 
     // go to parsing castling rights
     fen += 2;
@@ -251,10 +250,10 @@ void parse_fen(const char* fen)
     {
         switch (*fen)
         {
-        case 'K': castle |= wk; break;
-        case 'Q': castle |= wq; break;
-        case 'k': castle |= bk; break;
-        case 'q': castle |= bq; break;
+        case 'K': pos.castle |= wk; break;
+        case 'Q': pos.castle |= wq; break;
+        case 'k': pos.castle |= bk; break;
+        case 'q': pos.castle |= bq; break;
         case '-': break;
         }
 
@@ -273,28 +272,28 @@ void parse_fen(const char* fen)
         int rank = 8 - (fen[1] - '0');
 
         // init enpassant square
-        enpassant = rank * 8 + file;
+        pos.enpassant = rank * 8 + file;
     }
 
     // no enpassant square
     else
-        enpassant = no_sq;
+        pos.enpassant = no_sq;
 
     // loop over white pieces bitboards
     for (int piece = P; piece <= K; piece++)
         // populate white occupancy bitboard
-        occupancies[white] |= bitboards[piece];
+        pos.occupancies[white] |= pos.bitboards[piece];
 
     // loop over black pieces bitboards
     for (int piece = p; piece <= k; piece++)
         // populate white occupancy bitboard
-        occupancies[black] |= bitboards[piece];
+        pos.occupancies[black] |= pos.bitboards[piece];
 
     // init all occupancies
-    occupancies[both] |= occupancies[white];
-    occupancies[both] |= occupancies[black];
+    pos.occupancies[both] |= pos.occupancies[white];
+    pos.occupancies[both] |= pos.occupancies[black];
 
     // init hash key
-    hash_key = Zobrist::generate_hash_key();
+    pos.hash_key = Zobrist::generate_hash_key(pos);
 }
 
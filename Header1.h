@@ -12,6 +12,14 @@
 #include <io.h>
 #include <windows.h>
 #include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+// memory mapping (large pages for TT on Linux)
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 // Fen for starting position
 #define start_position "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 "
@@ -19,6 +27,9 @@
 // define bitboard data type
 #define U64 unsigned long long
 
+// define compact (16-bit) move data type
+#define U16 unsigned short
+
 // board squares
 enum {
     a8, b8, c8, d8, e8, f8, g8, h8,
@@ -40,7 +51,7 @@ enum { white, black, both };
 enum { rook, bishop };
 
 // encode pieces
-enum { P, N, B, R, Q, K, p, n, b, r, q, k };
+enum { P, N, B, R, Q, K, p, n, b, r, q, k, no_piece };
 
 // Castling rights binary encoding
 
@@ -71,40 +82,110 @@ const std::string square_to_coordinates[] = {
 };
 
 
-// "almost" unique position identifier aka hash key or position key
-U64 hash_key;
+#define set_bit(bitboard, square) ((bitboard) |= (1ULL << (square)))
+#define get_bit(bitboard, square) ((bitboard) & (1ULL << (square)))
+#define pop_bit(bitboard, square) (get_bit(bitboard, square) ? (bitboard) ^= (1ULL << (square)) : 0)
+
+
+// chess position (board state), functions working on the board take it explicitly
+typedef struct {
+    // piece bitboards
+    U64 bitboards[12];
+
+    // occupancy bitboards
+    U64 occupancies[3];
+
+    // pieces by square (no_piece on empty squares), kept in sync with piece bitboards
+    int piece_on[64];
+
+    // side to move
+    int side;
+
+    // enpassant square
+    int enpassant;
 
-// positions repetition table
-U64 repetition_table[1000];  // 1000 is a number of plies (500 moves) in the entire game
+    // castling rights
+    int castle;
 
-// repetition index
-int repetition_index;
+    // "almost" unique position identifier aka hash key or position key
+    U64 hash_key;
 
-// half move counter
-int ply;
+    // half move counter
+    int ply;
 
-#define set_bit(bitboard, square) (bitboard |= (1ULL << square))
-#define get_bit(bitboard, square) (bitboard & (1ULL << square))
-#define pop_bit(bitboard, square) (get_bit(bitboard, square) ? bitboard ^= (1ULL << square) : 0)
+    // positions repetition table
+    U64 repetition_table[1000];  // 1000 is a number of plies (500 moves) in the entire game
 
+    // repetition index
+    int repetition_index;
+} Position;
+
+/*
+    Bit primitives instruction set (build option, e.g. /D BIT_ISA=1 or -DBIT_ISA=1)
+
+    0 - portable C++ (Brian Kernighan's bit count, LS1B index via bit count)
+    1 - hardware bit scan (BSF) with software bit count, runs on any x64 CPU
+    2 - POPCNT & TZCNT instructions (Intel Haswell / AMD Zen and newer,
+        GCC & Clang need -mpopcnt -mbmi or -march=native to emit them)
+*/
+#ifndef BIT_ISA
+#if defined(_M_X64) || defined(__x86_64__)
+#define BIT_ISA 2
+#else
+#define BIT_ISA 0
+#endif
+#endif
+
+#if BIT_ISA > 0 && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+/*
+    Slider attacks backend (build option, e.g. /D USE_PEXT=1 or -DUSE_PEXT=1)
 
-// piece bitboards
-U64 bitboards[12];
+    0 - magic bitboards only
+    1 - BMI2 PEXT indexing when CPUID reports BMI2 at startup, magic bitboards otherwise
+        (only PEXT lookups are compiled for BMI2, so don't build with -mbmi2 or -march=native
+        unless the engine runs on BMI2 CPUs only)
+*/
+#ifndef USE_PEXT
+#define USE_PEXT 0
+#endif
 
-// occupancy bitboards
-U64 occupancies[3];
+/*
+    Slider attack tables generation (build option, e.g. /D CONSTEXPR_SLIDERS=1 or -DCONSTEXPR_SLIDERS=1)
 
-// side to move
-int side;
+    0 - generated by init_all at start up (default on MSVC & Clang)
+    1 - generated at compile time (default on GCC, MSVC needs /constexpr:steps100000000
+        and Clang needs -fconstexpr-steps=100000000)
+*/
+#ifndef CONSTEXPR_SLIDERS
+#if defined(__GNUC__) && !defined(__clang__)
+#define CONSTEXPR_SLIDERS 1
+#else
+#define CONSTEXPR_SLIDERS 0
+#endif
+#endif
 
-// enpassant square
-int enpassant = no_sq;
+#if USE_PEXT
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
 
-// castling rights
-int castle;
+// compile a function for BMI2 regardless of build target (MSVC emits intrinsics without it)
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_BMI2 __attribute__((target("bmi2")))
+#else
+#define TARGET_BMI2
+#endif
+#endif
 
-// count bits within a bitboard (Brian Kernighan's way)
-int count_bits(U64 bitboard)
+// count bits within a bitboard (Brian Kernighan's way, also used by compile time tables)
+static inline constexpr int count_bits_portable(U64 bitboard)
 {
     // bit counter
     int count = 0;
@@ -123,14 +204,14 @@ int count_bits(U64 bitboard)
     return count;
 }
 
-// get least significant 1st bit index
-int get_ls1b_index(U64 bitboard)
+// get least significant 1st bit index (portable way)
+static inline constexpr int get_ls1b_index_portable(U64 bitboard)
 {
     // make sure bitboard is not 0
     if (bitboard)
     {
         // count trailing bits before LS1B
-        return count_bits((bitboard & ~(bitboard - 1)) - 1);
+        return count_bits_portable((bitboard & ~(bitboard - 1)) - 1);
     }
 
     //otherwise
@@ -138,3 +219,43 @@ int get_ls1b_index(U64 bitboard)
         // return illegal index
         return -1;
 }
+
+// count bits within a bitboard
+static inline int count_bits(U64 bitboard)
+{
+#if BIT_ISA >= 2 && defined(_MSC_VER)
+    // POPCNT instruction
+    return (int)__popcnt64(bitboard);
+#elif BIT_ISA >= 2
+    // POPCNT instruction (or compiler's bit count if it's not enabled)
+    return __builtin_popcountll(bitboard);
+#else
+    // software bit count
+    return count_bits_portable(bitboard);
+#endif
+}
+
+// get least significant 1st bit index
+static inline int get_ls1b_index(U64 bitboard)
+{
+    // make sure bitboard is not 0
+    if (bitboard == 0)
+        // return illegal index
+        return -1;
+
+#if BIT_ISA >= 2 && defined(_MSC_VER)
+    // TZCNT instruction
+    return (int)_tzcnt_u64(bitboard);
+#elif BIT_ISA >= 1 && defined(_MSC_VER)
+    // BSF instruction
+    unsigned long index;
+    _BitScanForward64(&index, bitboard);
+    return (int)index;
+#elif BIT_ISA >= 1
+    // BSF instruction (TZCNT when BMI is enabled)
+    return __builtin_ctzll(bitboard);
+#else
+    // software bit scan
+    return get_ls1b_index_portable(bitboard);
+#endif
+}
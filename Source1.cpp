@@ -5,11 +5,11 @@ namespace Zobrist
     // pseudo random number state
     unsigned int random_state = 1804289383;
 
-    // generate 32-bit pseudo legal numbers
-    unsigned int get_random_U32_number()
+    // generate 32-bit pseudo legal numbers updating given state
+    constexpr unsigned int get_random_U32_number(unsigned int& state)
     {
         // get current state
-        unsigned int number = random_state;
+        unsigned int number = state;
 
         // XOR shift algorithm
         number ^= number << 13;
@@ -17,46 +17,67 @@ namespace Zobrist
         number ^= number << 5;
 
         // update random number state
-        random_state = number;
+        state = number;
 
         // return random number
         return number;
     }
 
-    // generate 64-bit pseudo legal numbers
-    U64 get_random_U64_number()
+    // generate 64-bit pseudo legal numbers updating given state
+    constexpr U64 get_random_U64_number(unsigned int& state)
     {
-        // define 4 random numbers
-        U64 n1, n2, n3, n4;
-
         // init random numbers slicing 16 bits from MS1B side
-        n1 = (U64)(get_random_U32_number()) & 0xFFFF;
-        n2 = (U64)(get_random_U32_number()) & 0xFFFF;
-        n3 = (U64)(get_random_U32_number()) & 0xFFFF;
-        n4 = (U64)(get_random_U32_number()) & 0xFFFF;
+        U64 n1 = (U64)(get_random_U32_number(state)) & 0xFFFF;
+        U64 n2 = (U64)(get_random_U32_number(state)) & 0xFFFF;
+        U64 n3 = (U64)(get_random_U32_number(state)) & 0xFFFF;
+        U64 n4 = (U64)(get_random_U32_number(state)) & 0xFFFF;
 
         // return random number
         return n1 | (n2 << 16) | (n3 << 32) | (n4 << 48);
     }
 
+    // generate 32-bit pseudo legal numbers
+    unsigned int get_random_U32_number()
+    {
+        return get_random_U32_number(random_state);
+    }
 
-    // random piece keys [piece][square]
-    U64 piece_keys[12][64];
+    // generate 64-bit pseudo legal numbers
+    U64 get_random_U64_number()
+    {
+        return get_random_U64_number(random_state);
+    }
 
-    // random enpassant keys [square]
-    U64 enpassant_keys[64];
+    // generate 64-bit pseudo random hash key updating given state (xorshift64*)
+    // keys sliced from 32-bit XOR shift numbers above span only 32 bits (XOR shift is linear),
+    // which makes different positions share a hash key
+    constexpr U64 get_random_key(U64& state)
+    {
+        // XOR shift algorithm
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
 
-    // random castling keys
-    U64 castle_keys[16];
+        // scramble the state by multiplication (not linear in XOR arithmetic)
+        return state * 0x2545F4914F6CDD1DULL;
+    }
 
-    // random side key
-    U64 side_key;
+    // random hash keys
+    typedef struct {
+        U64 piece_keys[12][64];     // random piece keys [piece][square]
+        U64 enpassant_keys[64];     // random enpassant keys [square]
+        U64 castle_keys[16];        // random castling keys
+        U64 side_key;               // random side key
+    } RandomKeys;
 
-    // init random hash keys
-    void init_random_keys()
+    // generate random hash keys (at compile time)
+    constexpr RandomKeys generate_random_keys()
     {
-        // update pseudo random number state
-        random_state = 1804289383;
+        // random keys
+        RandomKeys keys = {};
+
+        // init pseudo random number state
+        U64 state = 1804289383;
 
         // loop over piece codes
         for (int piece = P; piece <= k; piece++)
@@ -64,25 +85,42 @@ namespace Zobrist
             // loop over board squares
             for (int square = 0; square < 64; square++)
                 // init random piece keys
-                piece_keys[piece][square] = get_random_U64_number();
+                keys.piece_keys[piece][square] = get_random_key(state);
         }
 
         // loop over board squares
         for (int square = 0; square < 64; square++)
             // init random enpassant keys
-            enpassant_keys[square] = get_random_U64_number();
+            keys.enpassant_keys[square] = get_random_key(state);
 
         // loop over castling keys
         for (int index = 0; index < 16; index++)
             // init castling keys
-            castle_keys[index] = get_random_U64_number();
+            keys.castle_keys[index] = get_random_key(state);
 
         // init random side key
-        side_key = get_random_U64_number();
+        keys.side_key = get_random_key(state);
+
+        return keys;
     }
 
+    // random hash keys (read-only data)
+    constexpr RandomKeys random_keys = generate_random_keys();
+
+    // random piece keys [piece][square]
+    constexpr const U64 (&piece_keys)[12][64] = random_keys.piece_keys;
+
+    // random enpassant keys [square]
+    constexpr const U64 (&enpassant_keys)[64] = random_keys.enpassant_keys;
+
+    // random castling keys
+    constexpr const U64 (&castle_keys)[16] = random_keys.castle_keys;
+
+    // random side key
+    constexpr const U64& side_key = random_keys.side_key;
+
     // generate "almost" unique position ID aka hash key from scratch
-    U64 generate_hash_key()
+    U64 generate_hash_key(const Position& pos)
     {
         // final hash key
         U64 final_key = 0ULL;
@@ -94,7 +132,7 @@ namespace Zobrist
         for (int piece = P; piece <= k; piece++)
         {
             // init piece bitboard copy
-            bitboard = bitboards[piece];
+            bitboard = pos.bitboards[piece];
 
             // loop over the pieces within a bitboard
             while (bitboard)
@@ -111,15 +149,15 @@ namespace Zobrist
         }
 
         // if enpassant square is on board
-        if (enpassant != no_sq)
+        if (pos.enpassant != no_sq)
             // hash enpassant
-            final_key ^= enpassant_keys[enpassant];
+            final_key ^= enpassant_keys[pos.enpassant];
 
         // hash castling rights
-        final_key ^= castle_keys[castle];
+        final_key ^= castle_keys[pos.castle];
 
         // hash the side only if black is to move
-        if (side == black) final_key ^= side_key;
+        if (pos.side == black) final_key ^= side_key;
 
         // return generated hash key
         return final_key;
@@ -176,19 +214,19 @@ namespace Zobrist
 */
 
 // not A file constant
-const U64 not_a_file = 18374403900871474942ULL;
+constexpr U64 not_a_file = 18374403900871474942ULL;
 
 // not H file constant
-const U64 not_h_file = 9187201950435737471ULL;
+constexpr U64 not_h_file = 9187201950435737471ULL;
 
 // not HG file constant
-const U64 not_hg_file = 4557430888798830399ULL;
+constexpr U64 not_hg_file = 4557430888798830399ULL;
 
 // not AB file constant
-const U64 not_ab_file = 18229723555195321596ULL;
+constexpr U64 not_ab_file = 18229723555195321596ULL;
 
 // bishop relevant occupancy bit count for every square on board
-const int bishop_relevant_bits[64] = {
+constexpr int bishop_relevant_bits[64] = {
     6, 5, 5, 5, 5, 5, 5, 6,
     5, 5, 5, 5, 5, 5, 5, 5,
     5, 5, 7, 7, 7, 7, 5, 5,
@@ -200,7 +238,7 @@ const int bishop_relevant_bits[64] = {
 };
 
 // rook relevant occupancy bit count for every square on board
-const int rook_relevant_bits[64] = {
+constexpr int rook_relevant_bits[64] = {
     12, 11, 11, 11, 11, 11, 11, 12,
     11, 10, 10, 10, 10, 10, 10, 11,
     11, 10, 10, 10, 10, 10, 10, 11,
@@ -212,7 +250,7 @@ const int rook_relevant_bits[64] = {
 };
 
 // rook magic numbers
-U64 rook_magic_numbers[64] = {
+constexpr U64 rook_magic_numbers[64] = {
     0x8a80104000800020ULL,
     0x140002000100040ULL,
     0x2801880a0017001ULL,
@@ -280,7 +318,7 @@ U64 rook_magic_numbers[64] = {
 };
 
 // bishop magic numbers
-U64 bishop_magic_numbers[64] = {
+constexpr U64 bishop_magic_numbers[64] = {
     0x40040844404084ULL,
     0x2004208a004208ULL,
     0x10190041080202ULL,
@@ -349,19 +387,8 @@ U64 bishop_magic_numbers[64] = {
 
 namespace Attacks
 {
-    // Creating Attack tables for Different pieces
-    U64 pawn_attacks[2][64];
-    U64 knight_attacks[64];
-    U64 king_attacks[64];
-    U64 bishop_attacks[64][512];
-    U64 rook_attacks[64][4096];
-    U64 queen_attacks[64];
-
-    U64 bishop_masks[64];
-    U64 rook_masks[64];
-
-    // set occupancies
-    U64 set_occupancy(int index, int bits_in_mask, U64 attack_mask)
+    // set occupancies (spread index bits over the attack mask bits)
+    constexpr U64 set_occupancy(int index, int bits_in_mask, U64 attack_mask)
     {
         // occupancy map
         U64 occupancy = 0ULL;
@@ -369,16 +396,16 @@ namespace Attacks
         // loop over the range of bits within attack mask
         for (int count = 0; count < bits_in_mask; count++)
         {
-            // get LS1B index of attacks mask
-            int square = get_ls1b_index(attack_mask);
+            // get LS1B of attacks mask
+            U64 square_bit = attack_mask & (0ULL - attack_mask);
 
             // pop LS1B in attack map
-            pop_bit(attack_mask, square);
+            attack_mask ^= square_bit;
 
             // make sure occupancy is on board
             if (index & (1 << count))
                 // populate occupancy map
-                occupancy |= (1ULL << square);
+                occupancy |= square_bit;
         }
 
         // return occupancy map
@@ -386,16 +413,13 @@ namespace Attacks
     }
 
     // generate pawn attacks
-    U64 mask_pawn_attacks(int side, int square)
+    constexpr U64 mask_pawn_attacks(int side, int square)
     {
         // result attacks bitboard
         U64 attacks = 0ULL;
 
         // piece bitboard
-        U64 bitboard = 0ULL;
-
-        // set piece on board
-        set_bit(bitboard, square);
+        U64 bitboard = 1ULL << square;
 
         // white pawns
         if (!side)
@@ -418,16 +442,13 @@ namespace Attacks
     }
 
     // generate knight attacks
-    U64 mask_knight_attacks(int square)
+    constexpr U64 mask_knight_attacks(int square)
     {
         // result attacks bitboard
         U64 attacks = 0ULL;
 
         // piece bitboard
-        U64 bitboard = 0ULL;
-
-        // set piece on board
-        set_bit(bitboard, square);
+        U64 bitboard = 1ULL << square;
 
         // generate knight attacks
         if ((bitboard >> 17) & not_h_file) attacks |= (bitboard >> 17);
@@ -444,16 +465,13 @@ namespace Attacks
     }
 
     // generate king attacks
-    U64 mask_king_attacks(int square)
+    constexpr U64 mask_king_attacks(int square)
     {
         // result attacks bitboard
         U64 attacks = 0ULL;
 
         // piece bitboard
-        U64 bitboard = 0ULL;
-
-        // set piece on board
-        set_bit(bitboard, square);
+        U64 bitboard = 1ULL << square;
 
         // generate king attacks
         if (bitboard >> 8) attacks |= (bitboard >> 8);
@@ -469,15 +487,14 @@ namespace Attacks
         return attacks;
     }
 
-
     // mask bishop attacks
-    U64 mask_bishop_attacks(int square)
+    constexpr U64 mask_bishop_attacks(int square)
     {
         // result attacks bitboard
         U64 attacks = 0ULL;
 
         // init ranks & files
-        int r, f;
+        int r = 0, f = 0;
 
         // init target rank & files
         int tr = square / 8;
@@ -494,13 +511,13 @@ namespace Attacks
     }
 
     // mask rook attacks
-    U64 mask_rook_attacks(int square)
+    constexpr U64 mask_rook_attacks(int square)
     {
         // result attacks bitboard
         U64 attacks = 0ULL;
 
         // init ranks & files
-        int r, f;
+        int r = 0, f = 0;
 
         // init target rank & files
         int tr = square / 8;
@@ -517,13 +534,13 @@ namespace Attacks
     }
 
     // generate bishop attacks on the fly
-    U64 bishop_attacks_on_the_fly(int square, U64 block)
+    constexpr U64 bishop_attacks_on_the_fly(int square, U64 block)
     {
         // result attacks bitboard
         U64 attacks = 0ULL;
 
         // init ranks & files
-        int r, f;
+        int r = 0, f = 0;
 
         // init target rank & files
         int tr = square / 8;
@@ -559,13 +576,13 @@ namespace Attacks
     }
 
     // generate rook attacks on the fly
-    U64 rook_attacks_on_the_fly(int square, U64 block)
+    constexpr U64 rook_attacks_on_the_fly(int square, U64 block)
     {
         // result attacks bitboard
         U64 attacks = 0ULL;
 
         // init ranks & files
-        int r, f;
+        int r = 0, f = 0;
 
         // init target rank & files
         int tr = square / 8;
@@ -600,132 +617,406 @@ namespace Attacks
         return attacks;
     }
 
-    // get bishop attacks
-    U64 get_bishop_attacks(int square, U64 occupancy)
+    /*
+        All attack tables below are generated at compile time and placed in read-only data,
+        so engine start up doesn't compute them and processes share their pages.
+        The slider tables take the most of constexpr evaluation: they fit GCC's default
+        -fconstexpr-ops-limit, but not MSVC's and Clang's default step limits, so they are
+        generated at start up unless CONSTEXPR_SLIDERS is set (see Header1.h).
+    */
+
+    // leaper pieces attack tables
+    typedef struct {
+        U64 pawn_attacks[2][64];    // pawn attacks [side][square]
+        U64 knight_attacks[64];     // knight attacks [square]
+        U64 king_attacks[64];       // king attacks [square]
+    } LeaperTables;
+
+    // generate leaper pieces attack tables
+    constexpr LeaperTables generate_leaper_tables()
     {
-        // get bishop attacks assuming current board occupancy
-        occupancy &= bishop_masks[square];
-        occupancy *= bishop_magic_numbers[square];
-        occupancy >>= 64 - bishop_relevant_bits[square];
+        // leaper attack tables
+        LeaperTables tables = {};
 
-        // return bishop attacks
-        return bishop_attacks[square][occupancy];
+        // loop over 64 board squares
+        for (int square = 0; square < 64; square++)
+        {
+            // init pawn attacks
+            tables.pawn_attacks[white][square] = mask_pawn_attacks(white, square);
+            tables.pawn_attacks[black][square] = mask_pawn_attacks(black, square);
+
+            // init knight attacks
+            tables.knight_attacks[square] = mask_knight_attacks(square);
+
+            //init king attacks
+            tables.king_attacks[square] = mask_king_attacks(square);
+        }
+
+        return tables;
     }
 
-    // get rook attacks
-    U64 get_rook_attacks(int square, U64 occupancy)
+    // leaper pieces attack tables (read-only data)
+    constexpr LeaperTables leaper_tables = generate_leaper_tables();
+
+    // Creating Attack tables for Different pieces
+    constexpr const U64 (&pawn_attacks)[2][64] = leaper_tables.pawn_attacks;
+    constexpr const U64 (&knight_attacks)[64] = leaper_tables.knight_attacks;
+    constexpr const U64 (&king_attacks)[64] = leaper_tables.king_attacks;
+
+    // LS1B index lookup for de Bruijn multiplication (used by compile time tables)
+    constexpr int debruijn_index[64] = {
+         0,  1, 48,  2, 57, 49, 28,  3,
+        61, 58, 50, 42, 38, 29, 17,  4,
+        62, 55, 59, 36, 53, 51, 43, 22,
+        45, 39, 33, 30, 24, 18, 12,  5,
+        63, 47, 56, 27, 60, 41, 37, 16,
+        54, 35, 52, 21, 44, 32, 23, 11,
+        46, 26, 40, 15, 34, 20, 31, 10,
+        25, 14, 19,  9, 13,  8,  7,  6
+    };
+
+    // get least significant 1st bit index (de Bruijn multiplication, cheap in constexpr evaluation)
+    constexpr int get_ls1b_index_debruijn(U64 bitboard)
     {
-        // get rook attacks assuming current board occupancy
-        occupancy &= rook_masks[square];
-        occupancy *= rook_magic_numbers[square];
-        occupancy >>= 64 - rook_relevant_bits[square];
+        return debruijn_index[((bitboard & (0ULL - bitboard)) * 0x03f79d71b4cb0a89ULL) >> 58];
+    }
 
-        // return rook attacks
-        return rook_attacks[square][occupancy];
+    // get most significant 1st bit index (de Bruijn multiplication, cheap in constexpr evaluation)
+    constexpr int get_ms1b_index_debruijn(U64 bitboard)
+    {
+        // smear MS1B over all the lower bits
+        bitboard |= bitboard >> 1;
+        bitboard |= bitboard >> 2;
+        bitboard |= bitboard >> 4;
+        bitboard |= bitboard >> 8;
+        bitboard |= bitboard >> 16;
+        bitboard |= bitboard >> 32;
+
+        // isolate MS1B
+        return get_ls1b_index_debruijn(bitboard ^ (bitboard >> 1));
     }
 
-    // get queen attacks
-    U64 get_queen_attacks(int square, U64 occupancy)
+    // ray directions (rank & file steps): rook rays first, bishop rays next
+    constexpr int ray_rank_steps[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    constexpr int ray_file_steps[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+    // empty board rays
+    typedef struct {
+        U64 rays[8][64];            // squares seen from the square in a direction [direction][square]
+    } RayTables;
+
+    // generate empty board rays
+    constexpr RayTables generate_ray_tables()
     {
-        // init result attacks bitboard
-        U64 queen_attacks = 0ULL;
+        // ray tables
+        RayTables tables = {};
+
+        // loop over directions
+        for (int direction = 0; direction < 8; direction++)
+        {
+            // loop over 64 board squares
+            for (int square = 0; square < 64; square++)
+            {
+                // walk the ray until board edge
+                for (int r = square / 8 + ray_rank_steps[direction], f = square % 8 + ray_file_steps[direction];
+                    r >= 0 && r <= 7 && f >= 0 && f <= 7; r += ray_rank_steps[direction], f += ray_file_steps[direction])
+                    tables.rays[direction][square] |= 1ULL << (r * 8 + f);
+            }
+        }
 
-        // init bishop occupancies
-        U64 bishop_occupancy = occupancy;
+        return tables;
+    }
 
-        // init rook occupancies
-        U64 rook_occupancy = occupancy;
+    // empty board rays (only used to generate slider attack tables)
+    constexpr RayTables ray_tables = generate_ray_tables();
 
-        // get bishop attacks assuming current board occupancy
-        bishop_occupancy &= bishop_masks[square];
-        bishop_occupancy *= bishop_magic_numbers[square];
-        bishop_occupancy >>= 64 - bishop_relevant_bits[square];
+    // generate slider attacks along the rays cut at the nearest blockers
+    // (same as *_attacks_on_the_fly, but cheap enough to build the tables at compile time)
+    constexpr U64 slider_attacks_on_rays(int square, U64 block, int first_direction, int last_direction)
+    {
+        // result attacks bitboard
+        U64 attacks = 0ULL;
 
-        // get bishop attacks
-        queen_attacks = bishop_attacks[square][bishop_occupancy];
+        // loop over directions
+        for (int direction = first_direction; direction <= last_direction; direction++)
+        {
+            // init ray & blockers on it
+            U64 ray = ray_tables.rays[direction][square];
+            U64 blockers = ray & block;
 
-        // get bishop attacks assuming current board occupancy
-        rook_occupancy &= rook_masks[square];
-        rook_occupancy *= rook_magic_numbers[square];
-        rook_occupancy >>= 64 - rook_relevant_bits[square];
+            // cut the ray behind the nearest blocker (rays going to a1 increase square index)
+            if (blockers)
+                ray ^= ray_tables.rays[direction][(ray_rank_steps[direction] * 8 + ray_file_steps[direction] > 0) ?
+                    get_ls1b_index_debruijn(blockers) : get_ms1b_index_debruijn(blockers)];
 
-        // get rook attacks
-        queen_attacks |= rook_attacks[square][rook_occupancy];
+            // add ray to attacks
+            attacks |= ray;
+        }
 
-        // return queen attacks
-        return queen_attacks;
+        // return attack map
+        return attacks;
     }
 
+    // slider pieces attack tables
+    typedef struct {
+        U64 bishop_masks[64];       // relevant bishop occupancy bits [square]
+        U64 rook_masks[64];         // relevant rook occupancy bits [square]
+        int bishop_offsets[64];     // bishop table of every square within the shared table [square]
+        int rook_offsets[64];       // rook table of every square within the shared table [square]
 
-}
+        // bishop & rook attacks of all squares densely packed into one table
+        // (each square takes 2^relevant bits entries: 5248 for bishops, 102400 for rooks)
+        U64 attacks[5248 + 102400];
+    } SliderTables;
 
-// init leaper pieces attacks
-void init_leapers_attacks()
-{
-    // loop over 64 board squares
-    for (int square = 0; square < 64; square++)
+    // fill slider pieces attack tables (indexed by magic numbers or by PEXT) in place
+    constexpr void fill_slider_tables(SliderTables& tables, int pext)
+    {
+        // current table offset within the shared table
+        int offset = 0;
+
+        // loop over bishop & rook (bishop tables go first)
+        for (int bishop_piece = 1; bishop_piece >= 0; bishop_piece--)
+        {
+            // loop over 64 board squares
+            for (int square = 0; square < 64; square++)
+            {
+                // init current mask
+                U64 attack_mask = bishop_piece ? mask_bishop_attacks(square) : mask_rook_attacks(square);
+
+                // init relevant occupancy bit count
+                int relevant_bits_count = bishop_piece ? bishop_relevant_bits[square] : rook_relevant_bits[square];
+
+                // place current square's table into the shared table
+                if (bishop_piece) { tables.bishop_masks[square] = attack_mask; tables.bishop_offsets[square] = offset; }
+                else { tables.rook_masks[square] = attack_mask; tables.rook_offsets[square] = offset; }
+
+                // init magic number
+                U64 magic_number = bishop_piece ? bishop_magic_numbers[square] : rook_magic_numbers[square];
+
+                // init current occupancy variation & its index
+                U64 occupancy = 0ULL;
+                int index = 0;
+
+                // loop over all occupancy variations of the mask (Carry-Rippler trick
+                // enumerates them in the order of their indicies, i.e. of their PEXT)
+                do
+                {
+                    // init table index
+                    int table_index = pext ? index : (int)((occupancy * magic_number) >> (64 - relevant_bits_count));
+
+                    // init slider attacks
+                    tables.attacks[offset + table_index] = bishop_piece ?
+                        slider_attacks_on_rays(square, occupancy, 4, 7) : slider_attacks_on_rays(square, occupancy, 0, 3);
+
+                    // next occupancy variation
+                    occupancy = (occupancy - attack_mask) & attack_mask;
+                    index++;
+                } while (occupancy);
+
+                // skip the entries taken by current square
+                offset += 1 << relevant_bits_count;
+            }
+        }
+    }
+
+#if CONSTEXPR_SLIDERS
+    // generate slider pieces attack tables (indexed by magic numbers or by PEXT)
+    constexpr SliderTables generate_slider_tables(int pext)
     {
-        // init pawn attacks
-        Attacks::pawn_attacks[white][square] = Attacks::mask_pawn_attacks(white, square);
-        Attacks::pawn_attacks[black][square] = Attacks::mask_pawn_attacks(black, square);
+        // slider attack tables
+        SliderTables tables = {};
 
-        // init knight attacks
-        Attacks::knight_attacks[square] = Attacks::mask_knight_attacks(square);
+        fill_slider_tables(tables, pext);
 
-        //init king attacks
-        Attacks::king_attacks[square] = Attacks::mask_king_attacks(square);
+        return tables;
     }
-}
 
-// init slider piece's attack tables
-void init_sliders_attacks(int bishop)
-{
-    // loop over 64 board squares
-    for (int square = 0; square < 64; square++)
+    // slider pieces attack tables indexed by magic numbers (read-only data)
+    constexpr SliderTables slider_tables = generate_slider_tables(0);
+
+#if USE_PEXT
+    // slider pieces attack tables indexed by PEXT (read-only data)
+    constexpr SliderTables pext_slider_tables = generate_slider_tables(1);
+#endif
+#else
+    // slider pieces attack tables indexed by magic numbers (generated by init_slider_tables)
+    SliderTables slider_tables;
+
+#if USE_PEXT
+    // slider pieces attack tables indexed by PEXT (generated by init_slider_tables)
+    SliderTables pext_slider_tables;
+#endif
+#endif
+
+    // init slider pieces attack tables (nothing to do if they are generated at compile time)
+    void init_slider_tables()
     {
-        // init bishop & rook masks
-        Attacks::bishop_masks[square] = Attacks::mask_bishop_attacks(square);
-        Attacks::rook_masks[square] = Attacks::mask_rook_attacks(square);
+#if !CONSTEXPR_SLIDERS
+        fill_slider_tables(slider_tables, 0);
+
+#if USE_PEXT
+        fill_slider_tables(pext_slider_tables, 1);
+#endif
+#endif
+    }
+
+    // relevant occupancy masks
+    constexpr const U64 (&bishop_masks)[64] = slider_tables.bishop_masks;
+    constexpr const U64 (&rook_masks)[64] = slider_tables.rook_masks;
 
-        // init current mask
-        U64 attack_mask = bishop ? Attacks::bishop_masks[square] : Attacks::rook_masks[square];
+    // bishop & rook attacks shared table
+    constexpr const U64 (&slider_attacks)[5248 + 102400] = slider_tables.attacks;
 
-        // init relevant occupancy bit count
-        int relevant_bits_count = count_bits(attack_mask);
+    // squares between & line through two squares
+    typedef struct {
+        U64 between_masks[64][64];  // squares between two aligned squares (exclusive) [square][square]
+        U64 line_masks[64][64];     // full line (rank, file or diagonal) through two aligned squares [square][square]
+    } LineTables;
 
-        // init occupancy indicies
-        int occupancy_indicies = (1 << relevant_bits_count);
+    // generate between & line masks for every pair of squares
+    constexpr LineTables generate_line_tables()
+    {
+        // line tables
+        LineTables tables = {};
 
-        // loop over occupancy indicies
-        for (int index = 0; index < occupancy_indicies; index++)
+        // loop over 64 board squares
+        for (int source_square = 0; source_square < 64; source_square++)
         {
-            // bishop
-            if (bishop)
+            // loop over 64 board squares
+            for (int target_square = 0; target_square < 64; target_square++)
             {
-                // init current occupancy variation
-                U64 occupancy = Attacks::set_occupancy(index, relevant_bits_count, attack_mask);
+                // same square is not a line
+                if (source_square == target_square)
+                    continue;
 
-                // init magic index
-                int magic_index = (occupancy * bishop_magic_numbers[square]) >> (64 - bishop_relevant_bits[square]);
+                // squares are on the same rank or file
+                if (rook_attacks_on_the_fly(source_square, 0ULL) & (1ULL << target_square))
+                {
+                    // squares seen by rooks on both squares blocking each other
+                    tables.between_masks[source_square][target_square] =
+                        rook_attacks_on_the_fly(source_square, 1ULL << target_square) &
+                        rook_attacks_on_the_fly(target_square, 1ULL << source_square);
+
+                    // rank or file through both squares
+                    tables.line_masks[source_square][target_square] =
+                        (rook_attacks_on_the_fly(source_square, 0ULL) &
+                         rook_attacks_on_the_fly(target_square, 0ULL)) |
+                        (1ULL << source_square) | (1ULL << target_square);
+                }
 
-                // init bishop attacks
-                Attacks::bishop_attacks[square][magic_index] = Attacks::bishop_attacks_on_the_fly(square, occupancy);
+                // squares are on the same diagonal
+                else if (bishop_attacks_on_the_fly(source_square, 0ULL) & (1ULL << target_square))
+                {
+                    // squares seen by bishops on both squares blocking each other
+                    tables.between_masks[source_square][target_square] =
+                        bishop_attacks_on_the_fly(source_square, 1ULL << target_square) &
+                        bishop_attacks_on_the_fly(target_square, 1ULL << source_square);
+
+                    // diagonal through both squares
+                    tables.line_masks[source_square][target_square] =
+                        (bishop_attacks_on_the_fly(source_square, 0ULL) &
+                         bishop_attacks_on_the_fly(target_square, 0ULL)) |
+                        (1ULL << source_square) | (1ULL << target_square);
+                }
             }
+        }
 
-            // rook
-            else
-            {
-                // init current occupancy variation
-                U64 occupancy = Attacks::set_occupancy(index, relevant_bits_count, attack_mask);
+        return tables;
+    }
 
-                // init magic index
-                int magic_index = (occupancy * rook_magic_numbers[square]) >> (64 - rook_relevant_bits[square]);
+    // between & line masks (read-only data)
+    constexpr LineTables line_tables = generate_line_tables();
 
-                // init bishop attacks
-                Attacks::rook_attacks[square][magic_index] = Attacks::rook_attacks_on_the_fly(square, occupancy);
+    // squares between two aligned squares (exclusive) [square][square]
+    constexpr const U64 (&between_masks)[64][64] = line_tables.between_masks;
 
-            }
-        }
+    // full line (rank, file or diagonal) through two aligned squares [square][square]
+    constexpr const U64 (&line_masks)[64][64] = line_tables.line_masks;
+
+    // index slider attack tables by PEXT instead of magic multiplication (set at startup)
+    int pext_enabled = 0;
+
+    // check if CPU supports BMI2 instructions (PEXT)
+    int cpu_has_bmi2()
+    {
+#if USE_PEXT && defined(_MSC_VER)
+        // CPUID leaf 7 (extended features), BMI2 is EBX bit 8
+        int registers[4];
+        __cpuidex(registers, 7, 0);
+        return (registers[1] >> 8) & 1;
+#elif USE_PEXT
+        // CPUID leaf 7 (extended features), BMI2 is EBX bit 8
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return 0;
+        return (ebx >> 8) & 1;
+#else
+        // PEXT backend is not compiled in
+        return 0;
+#endif
+    }
+
+    // pick slider attacks backend
+    void init_sliders_backend()
+    {
+        pext_enabled = cpu_has_bmi2();
+    }
+
+#if USE_PEXT
+    // get bishop attacks by gathering relevant occupancy bits (called only if CPU has BMI2)
+    TARGET_BMI2 static U64 get_bishop_attacks_pext(int square, U64 occupancy)
+    {
+        return pext_slider_tables.attacks[slider_tables.bishop_offsets[square] + _pext_u64(occupancy, bishop_masks[square])];
+    }
+
+    // get rook attacks by gathering relevant occupancy bits (called only if CPU has BMI2)
+    TARGET_BMI2 static U64 get_rook_attacks_pext(int square, U64 occupancy)
+    {
+        return pext_slider_tables.attacks[slider_tables.rook_offsets[square] + _pext_u64(occupancy, rook_masks[square])];
+    }
+#endif
+
+    // get bishop attacks
+    static inline U64 get_bishop_attacks(int square, U64 occupancy)
+    {
+#if USE_PEXT
+        // gather relevant occupancy bits
+        if (pext_enabled)
+            return get_bishop_attacks_pext(square, occupancy);
+#endif
+
+        // hash relevant occupancy bits by magic number
+        occupancy &= bishop_masks[square];
+        occupancy *= bishop_magic_numbers[square];
+        occupancy >>= 64 - bishop_relevant_bits[square];
+
+        // return bishop attacks assuming current board occupancy
+        return slider_attacks[slider_tables.bishop_offsets[square] + occupancy];
+    }
+
+    // get rook attacks
+    static inline U64 get_rook_attacks(int square, U64 occupancy)
+    {
+#if USE_PEXT
+        // gather relevant occupancy bits
+        if (pext_enabled)
+            return get_rook_attacks_pext(square, occupancy);
+#endif
+
+        // hash relevant occupancy bits by magic number
+        occupancy &= rook_masks[square];
+        occupancy *= rook_magic_numbers[square];
+        occupancy >>= 64 - rook_relevant_bits[square];
+
+        // return rook attacks assuming current board occupancy
+        return slider_attacks[slider_tables.rook_offsets[square] + occupancy];
+    }
+
+    // get queen attacks
+    static inline U64 get_queen_attacks(int square, U64 occupancy)
+    {
+        // return bishop & rook attacks assuming current board occupancy
+        return get_bishop_attacks(square, occupancy) | get_rook_attacks(square, occupancy);
     }
 }
 
@@ -751,44 +1042,66 @@ namespace MoveGeneration
 
 // encode move
 #define encode_move(source, target, piece, promoted, capture, Double, enpassant, castling) \
-    (source) |          \
-    (target << 6) |     \
-    (piece << 12) |     \
-    (promoted << 16) |  \
-    (capture << 20) |   \
-    (Double << 21) |    \
-    (enpassant << 22) | \
-    (castling << 23)    \
+   ((source) |            \
+    ((target) << 6) |     \
+    ((piece) << 12) |     \
+    ((promoted) << 16) |  \
+    ((capture) << 20) |   \
+    ((Double) << 21) |    \
+    ((enpassant) << 22) | \
+    ((castling) << 23))   \
 
 // extract move items
-#define get_move_source(move) (move & 0x3f)
-#define get_move_target(move) ((move & 0xfc0) >> 6)
-#define get_move_piece(move) ((move & 0xf000) >> 12)
-#define get_move_promoted(move) ((move & 0xf0000) >> 16)
-#define get_move_capture(move) (move & 0x100000)
-#define get_move_double(move) (move & 0x200000)
-#define get_move_enpassant(move) (move & 0x400000)
-#define get_move_castling(move) (move & 0x800000)
+#define get_move_source(move) ((move) & 0x3f)
+#define get_move_target(move) (((move) & 0xfc0) >> 6)
+#define get_move_piece(move) (((move) & 0xf000) >> 12)
+#define get_move_promoted(move) (((move) & 0xf0000) >> 16)
+#define get_move_capture(move) ((move) & 0x100000)
+#define get_move_double(move) ((move) & 0x200000)
+#define get_move_enpassant(move) ((move) & 0x400000)
+#define get_move_castling(move) ((move) & 0x800000)
+
+// captures & queen promotions (moves searched by quiescence)
+#define get_move_tactical(move) (get_move_capture(move) || get_move_promoted(move) == Q || get_move_promoted(move) == q)
+
+/*
+          compact move bits (TT, PV, killers)           hexidecimal constants
+
+              0000 0000 0011 1111    source square       0x3f
+              0000 1111 1100 0000    target square       0xfc0
+              1111 0000 0000 0000    promoted piece      0xf000
+
+    piece & flags are taken from the board when the move is expanded back
+*/
+
+// encode compact move from a move
+#define compact_move(move) ((U16)(((move) & 0xfff) | (((move) & 0xf0000) >> 4)))
+
+// extract compact move promoted piece (source & target squares are at the same bits as in a move)
+#define get_compact_promoted(move) (((move) & 0xf000) >> 12)
 
 
 // preserve board state
-#define copy_board()                                                      \
-    U64 bitboards_copy[12], occupancies_copy[3];                          \
-    int side_copy, enpassant_copy, castle_copy;                           \
-    memcpy(bitboards_copy, bitboards, 96);                                \
-    memcpy(occupancies_copy, occupancies, 24);                            \
-    side_copy = side, enpassant_copy = enpassant, castle_copy = castle;   \
-    U64 hash_key_copy = hash_key;
+#define copy_board()                                                                 \
+    U64 bitboards_copy[12], occupancies_copy[3];                                     \
+    int piece_on_copy[64];                                                           \
+    int side_copy, enpassant_copy, castle_copy;                                      \
+    memcpy(bitboards_copy, pos.bitboards, 96);                                       \
+    memcpy(occupancies_copy, pos.occupancies, 24);                                   \
+    memcpy(piece_on_copy, pos.piece_on, 256);                                        \
+    side_copy = pos.side, enpassant_copy = pos.enpassant, castle_copy = pos.castle;  \
+    U64 hash_key_copy = pos.hash_key;
 
 // restore board state
-#define take_back()                                                       \
-    memcpy(bitboards, bitboards_copy, 96);                                \
-    memcpy(occupancies, occupancies_copy, 24);                            \
-    side = side_copy, enpassant = enpassant_copy, castle = castle_copy;   \
-    hash_key = hash_key_copy;
+#define take_back()                                                                  \
+    memcpy(pos.bitboards, bitboards_copy, 96);                                       \
+    memcpy(pos.occupancies, occupancies_copy, 24);                                   \
+    memcpy(pos.piece_on, piece_on_copy, 256);                                        \
+    pos.side = side_copy, pos.enpassant = enpassant_copy, pos.castle = castle_copy;  \
+    pos.hash_key = hash_key_copy;
 
 // move types
-    enum { all_moves, only_captures };
+    enum { all_moves, only_captures, only_quiets };
 
     /*
                                castling   move     in      in
@@ -815,12 +1128,28 @@ namespace MoveGeneration
         13, 15, 15, 15, 12, 15, 15, 14
     };
 
-   
+    // move list (fixed capacity, lives on the caller's stack)
+    typedef struct {
+        int moves[256];     // moves
+        int count;          // number of moves in the list
+    } MoveList;
+
+    // undo record (board state a move can't be taken back from, lives on the caller's stack)
+    typedef struct {
+        int captured_piece; // captured piece (no_piece on quiet moves)
+        int enpassant;      // enpassant square before the move
+        int castle;         // castling rights before the move
+        U64 hash_key;       // hash key before the move
+    } Undo;
+
     // add move to the move list
-    void add_move(std::vector<int>& move_list, int move)
+    void add_move(MoveList& move_list, int move)
     {
-        move_list.push_back(move);
+        // store move
+        move_list.moves[move_list.count] = move;
 
+        // increment move count
+        move_list.count++;
     }
 
     // print move (for UCI purposes)
@@ -832,16 +1161,25 @@ namespace MoveGeneration
     }
 
 
+    // print compact move (for UCI purposes)
+    void print_compact_move(U16 move)
+    {
+        std::cout << square_to_coordinates[get_move_source(move)] << \
+            square_to_coordinates[get_move_target(move)] << \
+            promoted_pieces[get_compact_promoted(move)] << "\n";
+    }
+
+
     // print move list
-    void print_move_list(std::vector<int>& move_list)
+    void print_move_list(MoveList& move_list)
     {
         std::cout << "move   piece   capture   double   enpass   castling\n\n";
 
         // loop over moves within a move list
-        for (int move_count = 0; move_count < move_list.size(); move_count++)
+        for (int move_count = 0; move_count < move_list.count; move_count++)
         {
             // init move
-            int move = move_list[move_count];
+            int move = move_list.moves[move_count];
 
 
             // print move
@@ -858,38 +1196,233 @@ namespace MoveGeneration
 
         }
         // print total number of moves
-        std::cout << "\n\n    Total number of moves: " << move_list.size() << "\n\n";
+        std::cout << "\n\n    Total number of moves: " << move_list.count << "\n\n";
     }
 
-    int is_square_attacked(int square, int side)
+    // is square attacked by the given side assuming given occupancy (attacking side is known at compile time)
+    template <int color>
+    static inline int is_square_attacked(const Position& pos, int square, U64 occupancy)
     {
-        // attacked by white pawns
-        if ((side == white) && (Attacks::pawn_attacks[black][square] & bitboards[P])) return 1;
+        // attacking piece bitboards offset (attacking piece = white piece + offset)
+        constexpr int offset = (color == white) ? 0 : 6;
 
-        // attacked by black pawns
-        if ((side == black) && (Attacks::pawn_attacks[white][square] & bitboards[p])) return 1;
+        // attacked by pawns
+        if (Attacks::pawn_attacks[color ^ 1][square] & pos.bitboards[P + offset]) return 1;
 
         // attacked by knights
-        if (Attacks::knight_attacks[square] & ((side == white) ? bitboards[N] : bitboards[n])) return 1;
+        if (Attacks::knight_attacks[square] & pos.bitboards[N + offset]) return 1;
 
         // attacked by bishops
-        if (Attacks::get_bishop_attacks(square, occupancies[both]) & ((side == white) ? bitboards[B] : bitboards[b])) return 1;
+        if (Attacks::get_bishop_attacks(square, occupancy) & pos.bitboards[B + offset]) return 1;
 
         // attacked by rooks
-        if (Attacks::get_rook_attacks(square, occupancies[both]) & ((side == white) ? bitboards[R] : bitboards[r])) return 1;
+        if (Attacks::get_rook_attacks(square, occupancy) & pos.bitboards[R + offset]) return 1;
 
-        // attacked by bishops
-        if (Attacks::get_queen_attacks(square, occupancies[both]) & ((side == white) ? bitboards[Q] : bitboards[q])) return 1;
+        // attacked by queens
+        if (Attacks::get_queen_attacks(square, occupancy) & pos.bitboards[Q + offset]) return 1;
 
         // attacked by kings
-        if (Attacks::king_attacks[square] & ((side == white) ? bitboards[K] : bitboards[k])) return 1;
+        if (Attacks::king_attacks[square] & pos.bitboards[K + offset]) return 1;
 
         // by default return false
         return 0;
     }
 
+    // is square attacked by the given side assuming given occupancy
+    int is_square_attacked(const Position& pos, int square, int side, U64 occupancy)
+    {
+        return (side == white) ? is_square_attacked<white>(pos, square, occupancy) :
+                                 is_square_attacked<black>(pos, square, occupancy);
+    }
+
+    // is square attacked by the given side
+    int is_square_attacked(const Position& pos, int square, int side)
+    {
+        return is_square_attacked(pos, square, side, pos.occupancies[both]);
+    }
+
+    // bitboard of all the pieces (of both sides) attacking the square assuming given occupancy
+    static inline U64 attackers_to(const Position& pos, int square, U64 occupancy)
+    {
+        // diagonal & straight sliders of both sides
+        U64 diagonal_sliders = pos.bitboards[B] | pos.bitboards[b] | pos.bitboards[Q] | pos.bitboards[q];
+        U64 straight_sliders = pos.bitboards[R] | pos.bitboards[r] | pos.bitboards[Q] | pos.bitboards[q];
+
+        return (Attacks::pawn_attacks[black][square] & pos.bitboards[P]) |
+               (Attacks::pawn_attacks[white][square] & pos.bitboards[p]) |
+               (Attacks::knight_attacks[square] & (pos.bitboards[N] | pos.bitboards[n])) |
+               (Attacks::get_bishop_attacks(square, occupancy) & diagonal_sliders) |
+               (Attacks::get_rook_attacks(square, occupancy) & straight_sliders) |
+               (Attacks::king_attacks[square] & (pos.bitboards[K] | pos.bitboards[k]));
+    }
+
+    // bitboard of all the pieces (of both sides) attacking the square
+    static inline U64 attackers_to(const Position& pos, int square)
+    {
+        return attackers_to(pos, square, pos.occupancies[both]);
+    }
+
+    // check & pin information for the side to move
+    typedef struct {
+        int king_square;    // side to move king square
+        U64 checkers;       // enemy pieces giving check
+        U64 pinned;         // side to move pieces pinned to the king
+        U64 check_mask;     // target squares resolving the check for non-king moves
+        int enemy_king_square;      // enemy king square
+        U64 check_squares[6];       // squares side to move pieces would give check from [white piece type]
+        U64 discovered_candidates;  // side to move pieces blocking own sliders' lines to the enemy king
+    } CheckInfo;
+
+    // init check & pin information for the side to move (known at compile time)
+    template <int color>
+    void init_check_info(const Position& pos, CheckInfo& check_info)
+    {
+        // enemy & own piece bitboards offsets (piece = white piece + offset)
+        constexpr int offset = (color == white) ? 6 : 0;
+        constexpr int own_offset = (color == white) ? 0 : 6;
+
+        // init king square
+        int king_square = get_ls1b_index(pos.bitboards[(color == white) ? K : k]);
+
+        // enemy sliders
+        U64 diagonal_sliders = pos.bitboards[B + offset] | pos.bitboards[Q + offset];
+        U64 straight_sliders = pos.bitboards[R + offset] | pos.bitboards[Q + offset];
+
+        // init checkers
+        U64 checkers =
+            (Attacks::pawn_attacks[color][king_square] & pos.bitboards[P + offset]) |
+            (Attacks::knight_attacks[king_square] & pos.bitboards[N + offset]) |
+            (Attacks::get_bishop_attacks(king_square, pos.occupancies[both]) & diagonal_sliders) |
+            (Attacks::get_rook_attacks(king_square, pos.occupancies[both]) & straight_sliders);
+
+        // enemy sliders aiming at the king through own pieces only
+        U64 snipers =
+            (Attacks::get_bishop_attacks(king_square, pos.occupancies[color ^ 1]) & diagonal_sliders) |
+            (Attacks::get_rook_attacks(king_square, pos.occupancies[color ^ 1]) & straight_sliders);
+
+        // init pinned pieces
+        U64 pinned = 0ULL;
+
+        // loop over snipers
+        while (snipers)
+        {
+            // init sniper square
+            int sniper_square = get_ls1b_index(snipers);
+
+            // pieces between the king and the sniper
+            U64 blockers = Attacks::between_masks[king_square][sniper_square] & pos.occupancies[both];
+
+            // single own piece between the king and the sniper is pinned
+            if (blockers && !(blockers & (blockers - 1)) && (blockers & pos.occupancies[color]))
+                pinned |= blockers;
+
+            // pop ls1b of snipers
+            pop_bit(snipers, sniper_square);
+        }
+
+        // init check info
+        check_info.king_square = king_square;
+        check_info.checkers = checkers;
+        check_info.pinned = pinned;
+
+        // not in check: any square will do
+        if (checkers == 0)
+            check_info.check_mask = ~0ULL;
+
+        // single check: capture the checker or block the check
+        else if (!(checkers & (checkers - 1)))
+            check_info.check_mask = checkers | Attacks::between_masks[king_square][get_ls1b_index(checkers)];
+
+        // double check: only king moves
+        else
+            check_info.check_mask = 0ULL;
+
+        // init enemy king square
+        int enemy_king_square = get_ls1b_index(pos.bitboards[(color == white) ? k : K]);
+        check_info.enemy_king_square = enemy_king_square;
+
+        // squares own pieces would attack the enemy king from
+        check_info.check_squares[P] = Attacks::pawn_attacks[color ^ 1][enemy_king_square];
+        check_info.check_squares[N] = Attacks::knight_attacks[enemy_king_square];
+        check_info.check_squares[B] = Attacks::get_bishop_attacks(enemy_king_square, pos.occupancies[both]);
+        check_info.check_squares[R] = Attacks::get_rook_attacks(enemy_king_square, pos.occupancies[both]);
+        check_info.check_squares[Q] = check_info.check_squares[B] | check_info.check_squares[R];
+        check_info.check_squares[K] = 0ULL;
+
+        // own sliders aiming at the enemy king through own pieces only
+        snipers =
+            (Attacks::get_bishop_attacks(enemy_king_square, pos.occupancies[color ^ 1]) & (pos.bitboards[B + own_offset] | pos.bitboards[Q + own_offset])) |
+            (Attacks::get_rook_attacks(enemy_king_square, pos.occupancies[color ^ 1]) & (pos.bitboards[R + own_offset] | pos.bitboards[Q + own_offset]));
+
+        // init discovered check candidates
+        U64 discovered_candidates = 0ULL;
+
+        // loop over snipers
+        while (snipers)
+        {
+            // init sniper square
+            int sniper_square = get_ls1b_index(snipers);
+
+            // pieces between the enemy king and the sniper
+            U64 blockers = Attacks::between_masks[enemy_king_square][sniper_square] & pos.occupancies[both];
+
+            // single own piece between the enemy king and the sniper discovers check when it moves off the line
+            if (blockers && !(blockers & (blockers - 1)) && (blockers & pos.occupancies[color]))
+                discovered_candidates |= blockers;
+
+            // pop ls1b of snipers
+            pop_bit(snipers, sniper_square);
+        }
+
+        check_info.discovered_candidates = discovered_candidates;
+    }
+
+    // init check & pin information for current position
+    void init_check_info(const Position& pos, CheckInfo& check_info)
+    {
+        (pos.side == white) ? init_check_info<white>(pos, check_info) : init_check_info<black>(pos, check_info);
+    }
+
+    // legal target squares for the piece on a given square (check evasions & pins)
+    static inline U64 get_legal_targets(const CheckInfo& check_info, int square)
+    {
+        // pinned pieces can only move along the pin line
+        if (get_bit(check_info.pinned, square))
+            return check_info.check_mask & Attacks::line_masks[check_info.king_square][square];
+
+        return check_info.check_mask;
+    }
+
+    // is enpassant capture legal (captured pawn may expose the king along the rank)
+    template <int color>
+    static inline int is_enpassant_legal(const Position& pos, const CheckInfo& check_info, int source_square)
+    {
+        // enemy piece bitboards offset (enemy piece = white piece + offset)
+        constexpr int offset = (color == white) ? 6 : 0;
+
+        // init captured pawn square
+        int captured_square = (color == white) ? pos.enpassant + 8 : pos.enpassant - 8;
+
+        // knights & pawns (other than the captured one) giving check are not resolved
+        if (check_info.checkers & ~(1ULL << captured_square) & (pos.bitboards[N + offset] | pos.bitboards[P + offset]))
+            return 0;
+
+        // occupancy after the capture
+        U64 occupancy = (pos.occupancies[both] ^ (1ULL << source_square) ^ (1ULL << captured_square)) | (1ULL << pos.enpassant);
+
+        // make sure no slider attacks the king
+        if (Attacks::get_bishop_attacks(check_info.king_square, occupancy) & (pos.bitboards[B + offset] | pos.bitboards[Q + offset]))
+            return 0;
+
+        if (Attacks::get_rook_attacks(check_info.king_square, occupancy) & (pos.bitboards[R + offset] | pos.bitboards[Q + offset]))
+            return 0;
+
+        // enpassant capture is legal
+        return 1;
+    }
+
     // print attacked squares
-    void print_attacked_squares(int side)
+    void print_attacked_squares(const Position& pos, int side)
     {
         std::cout << "\n";
 
@@ -907,7 +1440,7 @@ namespace MoveGeneration
                     std::cout << 8 - rank;
 
                 // check whether current square is attacked or not
-                std::cout << (is_square_attacked(square, side) ? 1 : 0);
+                std::cout << (is_square_attacked(pos, square, side) ? 1 : 0);
             }
 
             // print new line every rank
@@ -918,676 +1451,935 @@ namespace MoveGeneration
         std::cout << "\n     a b c d e f g h\n\n";
     }
 
-    // generate all moves
-    void generate_moves(std::vector<int>& move_list)
+    // add moves of the piece from source square to every target square (captures are flagged by enemy occupancy)
+    static inline void add_piece_moves(MoveList& move_list, int piece, int source_square, U64 attacks, U64 enemy_occupancy)
+    {
+        // loop over target squares
+        while (attacks)
+        {
+            // init target square
+            int target_square = get_ls1b_index(attacks);
+
+            // quiet move or capture
+            int capture = get_bit(enemy_occupancy, target_square) ? 1 : 0;
+
+            add_move(move_list, encode_move(source_square, target_square, piece, 0, capture, 0, 0, 0));
+
+            // pop ls1b in current attacks set
+            pop_bit(attacks, target_square);
+        }
+    }
+
+    // generate all legal moves of the side to move known at compile time (see generate_moves below)
+    template <int color>
+    void generate_moves(const Position& pos, MoveList& move_list, int move_flag, const CheckInfo& check_info)
     {
+        // own piece bitboards offset (own piece = white piece + offset)
+        constexpr int offset = (color == white) ? 0 : 6;
+
+        // pawn push direction
+        constexpr int push = (color == white) ? -8 : 8;
+
+        // first squares of the rank pawns promote from and the rank pawns start from
+        constexpr int promotion_rank = (color == white) ? a7 : a2;
+        constexpr int start_rank = (color == white) ? a2 : a7;
+
+        // castling rights & squares
+        constexpr int king_side = (color == white) ? wk : bk;
+        constexpr int queen_side = (color == white) ? wq : bq;
+        constexpr int king_from = (color == white) ? e1 : e8;
+        constexpr int king_side_to = (color == white) ? g1 : g8;
+        constexpr int queen_side_to = (color == white) ? c1 : c8;
+
+        // init move count
+        move_list.count = 0;
+
         // define source & target squares
         int source_square, target_square;
 
         // define current piece's bitboard copy & it's attacks
         U64 bitboard, attacks;
 
-        // loop over all the bitboards
-        for (int piece = P; piece <= k; piece++)
-        {
-            // init piece bitboard copy
-            bitboard = bitboards[piece];
+        // define legal target squares of the current pawn
+        U64 legal_targets;
 
-            // generate white pawns & white king castling moves
-            if (side == white)
-            {
-                // pick up white pawn bitboards index
-                if (piece == P)
-                {
-                    // loop over white pawns within white pawn bitboard
-                    while (bitboard)
-                    {
-                        // init source square
-                        source_square = get_ls1b_index(bitboard);
+        // enemy pieces
+        U64 enemy_occupancy = pos.occupancies[color ^ 1];
 
-                        // init target square
-                        target_square = source_square - 8;
+        // init target squares of the piece moves depending on move flag
+        U64 targets = (move_flag == only_captures) ? enemy_occupancy :
+                      (move_flag == only_quiets) ? ~pos.occupancies[both] : ~pos.occupancies[color];
 
-                        // generate quite pawn moves
-                        if (!(target_square < a8) && !get_bit(occupancies[both], target_square))
-                        {
-                            // pawn promotion
-                            if (source_square >= a7 && source_square <= h7)
-                            {
-                                add_move(move_list, encode_move(source_square, target_square, piece, Q, 0, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, R, 0, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, B, 0, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, N, 0, 0, 0, 0));
-                            }
-
-                            else
-                            {
-                                // one square ahead pawn move
-                                add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-
-                                // two squares ahead pawn move
-                                if ((source_square >= a2 && source_square <= h2) && !get_bit(occupancies[both], target_square - 8))
-                                    add_move(move_list, encode_move(source_square, target_square - 8, piece, 0, 0, 1, 0, 0));
-                            }
-                        }
+        // init pawn bitboard copy
+        bitboard = pos.bitboards[P + offset];
 
-                        // init pawn attacks bitboard
-                        attacks = Attacks::pawn_attacks[side][source_square] & occupancies[black];
-
-                        // generate pawn captures
-                        while (attacks)
-                        {
-                            // init target square
-                            target_square = get_ls1b_index(attacks);
-
-                            // pawn promotion
-                            if (source_square >= a7 && source_square <= h7)
-                            {
-                                add_move(move_list, encode_move(source_square, target_square, piece, Q, 1, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, R, 1, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, B, 1, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, N, 1, 0, 0, 0));
-                            }
-
-                            else
-                                // one square ahead pawn move
-                                add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-
-                            // pop ls1b of the pawn attacks
-                            pop_bit(attacks, target_square);
-                        }
+        // loop over pawns
+        while (bitboard)
+        {
+            // init source square
+            source_square = get_ls1b_index(bitboard);
 
-                        // generate enpassant captures
-                        if (enpassant != no_sq)
-                        {
-                            // lookup pawn attacks and bitwise AND with enpassant square (bit)
-                            U64 enpassant_attacks = Attacks::pawn_attacks[side][source_square] & (1ULL << enpassant);
-
-                            // make sure enpassant capture available
-                            if (enpassant_attacks)
-                            {
-                                // init enpassant capture target square
-                                int target_enpassant = get_ls1b_index(enpassant_attacks);
-                                add_move(move_list, encode_move(source_square, target_enpassant, piece, 0, 1, 0, 1, 0));
-                            }
-                        }
+            // init legal target squares (pins & check evasions)
+            legal_targets = get_legal_targets(check_info, source_square);
 
-                        // pop ls1b from piece bitboard copy
-                        pop_bit(bitboard, source_square);
-                    }
-                }
+            // init target square
+            target_square = source_square + push;
 
-                if (piece == K)
+            // generate pawn pushes
+            if (!get_bit(pos.occupancies[both], target_square))
+            {
+                // pawn promotion
+                if (source_square >= promotion_rank && source_square <= promotion_rank + 7)
                 {
-                    // king side castling is available
-                    if (castle & wk)
+                    if (get_bit(legal_targets, target_square))
                     {
-                        // make sure square between king and king's rook are empty
-                        if (!get_bit(occupancies[both], f1) && !get_bit(occupancies[both], g1))
-                        {
-                            // make sure king and the f1 squares are not under attacks
-                            if (!is_square_attacked(e1, black) && !is_square_attacked(f1, black))
-                                add_move(move_list, encode_move(e1, g1, piece, 0, 0, 0, 0, 1));
-                        }
-                    }
+                        // queen promotion is searched along with captures
+                        if (move_flag != only_quiets)
+                            add_move(move_list, encode_move(source_square, target_square, P + offset, Q + offset, 0, 0, 0, 0));
 
-                    // queen side castling is available
-                    if (castle & wq)
-                    {
-                        // make sure square between king and queen's rook are empty
-                        if (!get_bit(occupancies[both], d1) && !get_bit(occupancies[both], c1) && !get_bit(occupancies[both], b1))
+                        // under promotions are searched along with quiet moves
+                        if (move_flag != only_captures)
                         {
-                            // make sure king and the d1 squares are not under attacks
-                            if (!is_square_attacked(e1, black) && !is_square_attacked(d1, black))
-                                add_move(move_list, encode_move(e1, c1, piece, 0, 0, 0, 0, 1));
+                            add_move(move_list, encode_move(source_square, target_square, P + offset, R + offset, 0, 0, 0, 0));
+                            add_move(move_list, encode_move(source_square, target_square, P + offset, B + offset, 0, 0, 0, 0));
+                            add_move(move_list, encode_move(source_square, target_square, P + offset, N + offset, 0, 0, 0, 0));
                         }
                     }
                 }
-            }
 
-            // generate black pawns & black king castling moves
-            else
-            {
-                // pick up black pawn bitboards index
-                if (piece == p)
+                else if (move_flag != only_captures)
                 {
-                    // loop over white pawns within white pawn bitboard
-                    while (bitboard)
-                    {
-                        // init source square
-                        source_square = get_ls1b_index(bitboard);
-
-                        // init target square
-                        target_square = source_square + 8;
-
-                        // generate quite pawn moves
-                        if (!(target_square > h1) && !get_bit(occupancies[both], target_square))
-                        {
-                            // pawn promotion
-                            if (source_square >= a2 && source_square <= h2)
-                            {
-                                add_move(move_list, encode_move(source_square, target_square, piece, q, 0, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, r, 0, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, b, 0, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, n, 0, 0, 0, 0));
-                            }
-
-                            else
-                            {
-                                // one square ahead pawn move
-                                add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
-                                // two squares ahead pawn move
-                                if ((source_square >= a7 && source_square <= h7) && !get_bit(occupancies[both], target_square + 8))
-                                    add_move(move_list, encode_move(source_square, target_square + 8, piece, 0, 0, 1, 0, 0));
-                            }
-                        }
+                    // one square ahead pawn move
+                    if (get_bit(legal_targets, target_square))
+                        add_move(move_list, encode_move(source_square, target_square, P + offset, 0, 0, 0, 0, 0));
 
-                        // init pawn attacks bitboard
-                        attacks = Attacks::pawn_attacks[side][source_square] & occupancies[white];
+                    // two squares ahead pawn move
+                    if ((source_square >= start_rank && source_square <= start_rank + 7) && !get_bit(pos.occupancies[both], target_square + push) && get_bit(legal_targets, target_square + push))
+                        add_move(move_list, encode_move(source_square, target_square + push, P + offset, 0, 0, 1, 0, 0));
+                }
+            }
 
-                        // generate pawn captures
-                        while (attacks)
-                        {
-                            // init target square
-                            target_square = get_ls1b_index(attacks);
-
-                            // pawn promotion
-                            if (source_square >= a2 && source_square <= h2)
-                            {
-                                add_move(move_list, encode_move(source_square, target_square, piece, q, 1, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, r, 1, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, b, 1, 0, 0, 0));
-                                add_move(move_list, encode_move(source_square, target_square, piece, n, 1, 0, 0, 0));
-                            }
-
-                            else
-                                // one square ahead pawn move
-                                add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
-
-                            // pop ls1b of the pawn attacks
-                            pop_bit(attacks, target_square);
-                        }
+            // init pawn attacks bitboard
+            attacks = (move_flag == only_quiets) ? 0ULL : Attacks::pawn_attacks[color][source_square] & enemy_occupancy & legal_targets;
 
-                        // generate enpassant captures
-                        if (enpassant != no_sq)
-                        {
-                            // lookup pawn attacks and bitwise AND with enpassant square (bit)
-                            U64 enpassant_attacks = Attacks::pawn_attacks[side][source_square] & (1ULL << enpassant);
-
-                            // make sure enpassant capture available
-                            if (enpassant_attacks)
-                            {
-                                // init enpassant capture target square
-                                int target_enpassant = get_ls1b_index(enpassant_attacks);
-                                add_move(move_list, encode_move(source_square, target_enpassant, piece, 0, 1, 0, 1, 0));
-                            }
-                        }
+            // generate pawn captures
+            while (attacks)
+            {
+                // init target square
+                target_square = get_ls1b_index(attacks);
 
-                        // pop ls1b from piece bitboard copy
-                        pop_bit(bitboard, source_square);
-                    }
+                // pawn promotion
+                if (source_square >= promotion_rank && source_square <= promotion_rank + 7)
+                {
+                    add_move(move_list, encode_move(source_square, target_square, P + offset, Q + offset, 1, 0, 0, 0));
+                    add_move(move_list, encode_move(source_square, target_square, P + offset, R + offset, 1, 0, 0, 0));
+                    add_move(move_list, encode_move(source_square, target_square, P + offset, B + offset, 1, 0, 0, 0));
+                    add_move(move_list, encode_move(source_square, target_square, P + offset, N + offset, 1, 0, 0, 0));
                 }
 
-                if (piece == k)
-                {
-                    // king side castling is available
-                    if (castle & bk)
-                    {
-                        // make sure square between king and king's rook are empty
-                        if (!get_bit(occupancies[both], f8) && !get_bit(occupancies[both], g8))
-                        {
-                            // make sure king and the f8 squares are not under attacks
-                            if (!is_square_attacked(e8, white) && !is_square_attacked(f8, white))
-                                add_move(move_list, encode_move(e8, g8, piece, 0, 0, 0, 0, 1));
-                        }
-                    }
+                else
+                    // one square ahead pawn move
+                    add_move(move_list, encode_move(source_square, target_square, P + offset, 0, 1, 0, 0, 0));
 
-                    // queen side castling is available
-                    if (castle & bq)
-                    {
-                        // make sure square between king and queen's rook are empty
-                        if (!get_bit(occupancies[both], d8) && !get_bit(occupancies[both], c8) && !get_bit(occupancies[both], b8))
-                        {
-                            // make sure king and the d8 squares are not under attacks
-                            if (!is_square_attacked(e8, white) && !is_square_attacked(d8, white))
-                                add_move(move_list, encode_move(e8, c8, piece, 0, 0, 0, 0, 1));
-                        }
-                    }
-                }
+                // pop ls1b of the pawn attacks
+                pop_bit(attacks, target_square);
             }
 
-            // genarate knight moves
-            if ((side == white) ? piece == N : piece == n)
+            // generate enpassant captures
+            if (pos.enpassant != no_sq && move_flag != only_quiets)
             {
-                // loop over source squares of piece bitboard copy
-                while (bitboard)
-                {
-                    // init source square
-                    source_square = get_ls1b_index(bitboard);
+                // lookup pawn attacks and bitwise AND with enpassant square (bit)
+                U64 enpassant_attacks = Attacks::pawn_attacks[color][source_square] & (1ULL << pos.enpassant);
 
-                    // init piece attacks in order to get set of target squares
-                    attacks = Attacks::knight_attacks[source_square] & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
+                // make sure enpassant capture available and legal
+                if (enpassant_attacks && is_enpassant_legal<color>(pos, check_info, source_square))
+                    add_move(move_list, encode_move(source_square, pos.enpassant, P + offset, 0, 1, 0, 1, 0));
+            }
 
-                    // loop over target squares available from generated attacks
-                    while (attacks)
-                    {
-                        // init target square
-                        target_square = get_ls1b_index(attacks);
+            // pop ls1b from piece bitboard copy
+            pop_bit(bitboard, source_square);
+        }
 
-                        // quite move
-                        if (!get_bit(((side == white) ? occupancies[black] : occupancies[white]), target_square))
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+        // genarate knight moves
+        for (bitboard = pos.bitboards[N + offset]; bitboard; pop_bit(bitboard, source_square))
+        {
+            source_square = get_ls1b_index(bitboard);
+            attacks = Attacks::knight_attacks[source_square] & targets & get_legal_targets(check_info, source_square);
+            add_piece_moves(move_list, N + offset, source_square, attacks, enemy_occupancy);
+        }
 
-                        else
-                            // capture move
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+        // generate bishop moves
+        for (bitboard = pos.bitboards[B + offset]; bitboard; pop_bit(bitboard, source_square))
+        {
+            source_square = get_ls1b_index(bitboard);
+            attacks = Attacks::get_bishop_attacks(source_square, pos.occupancies[both]) & targets & get_legal_targets(check_info, source_square);
+            add_piece_moves(move_list, B + offset, source_square, attacks, enemy_occupancy);
+        }
 
-                        // pop ls1b in current attacks set
-                        pop_bit(attacks, target_square);
-                    }
+        // generate rook moves
+        for (bitboard = pos.bitboards[R + offset]; bitboard; pop_bit(bitboard, source_square))
+        {
+            source_square = get_ls1b_index(bitboard);
+            attacks = Attacks::get_rook_attacks(source_square, pos.occupancies[both]) & targets & get_legal_targets(check_info, source_square);
+            add_piece_moves(move_list, R + offset, source_square, attacks, enemy_occupancy);
+        }
 
+        // generate queen moves
+        for (bitboard = pos.bitboards[Q + offset]; bitboard; pop_bit(bitboard, source_square))
+        {
+            source_square = get_ls1b_index(bitboard);
+            attacks = Attacks::get_queen_attacks(source_square, pos.occupancies[both]) & targets & get_legal_targets(check_info, source_square);
+            add_piece_moves(move_list, Q + offset, source_square, attacks, enemy_occupancy);
+        }
 
-                    // pop ls1b of the current piece bitboard copy
-                    pop_bit(bitboard, source_square);
-                }
-            }
+        // castling moves are quiet (king is not in check and squares it passes are not attacked)
+        if (move_flag != only_captures && !check_info.checkers)
+        {
+            // king side castling is available and squares between king and king's rook are empty
+            if ((pos.castle & king_side) && !get_bit(pos.occupancies[both], king_from + 1) && !get_bit(pos.occupancies[both], king_from + 2) &&
+                !is_square_attacked<color ^ 1>(pos, king_from + 1, pos.occupancies[both]) && !is_square_attacked<color ^ 1>(pos, king_from + 2, pos.occupancies[both]))
+                add_move(move_list, encode_move(king_from, king_side_to, K + offset, 0, 0, 0, 0, 1));
+
+            // queen side castling is available and squares between king and queen's rook are empty
+            if ((pos.castle & queen_side) && !get_bit(pos.occupancies[both], king_from - 1) && !get_bit(pos.occupancies[both], king_from - 2) && !get_bit(pos.occupancies[both], king_from - 3) &&
+                !is_square_attacked<color ^ 1>(pos, king_from - 1, pos.occupancies[both]) && !is_square_attacked<color ^ 1>(pos, king_from - 2, pos.occupancies[both]))
+                add_move(move_list, encode_move(king_from, queen_side_to, K + offset, 0, 0, 0, 0, 1));
+        }
 
-            // generate bishop moves
-            if ((side == white) ? piece == B : piece == b)
-            {
-                // loop over source squares of piece bitboard copy
-                while (bitboard)
-                {
-                    // init source square
-                    source_square = get_ls1b_index(bitboard);
+        // generate king moves
+        source_square = check_info.king_square;
 
-                    // init piece attacks in order to get set of target squares
-                    attacks = Attacks::get_bishop_attacks(source_square, occupancies[both]) & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
+        // occupancy without the king (king itself doesn't block attacks)
+        U64 occupancy = pos.occupancies[both] ^ (1ULL << source_square);
 
-                    // loop over target squares available from generated attacks
-                    while (attacks)
-                    {
-                        // init target square
-                        target_square = get_ls1b_index(attacks);
+        // loop over target squares
+        for (attacks = Attacks::king_attacks[source_square] & targets; attacks; pop_bit(attacks, target_square))
+        {
+            // init target square
+            target_square = get_ls1b_index(attacks);
 
-                        // quite move
-                        if (!get_bit(((side == white) ? occupancies[black] : occupancies[white]), target_square))
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+            // make sure king doesn't step into a check
+            if (is_square_attacked<color ^ 1>(pos, target_square, occupancy))
+                continue;
 
-                        else
-                            // capture move
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+            // quiet move or capture
+            int capture = get_bit(enemy_occupancy, target_square) ? 1 : 0;
 
-                        // pop ls1b in current attacks set
-                        pop_bit(attacks, target_square);
-                    }
+            add_move(move_list, encode_move(source_square, target_square, K + offset, 0, capture, 0, 0, 0));
+        }
+    }
 
+    // add pawn moves from source to target square (all promotions on the last rank, queen promotion and captures
+    // go with captures, the rest of the moves with quiet moves)
+    template <int color>
+    static inline void add_pawn_moves(MoveList& move_list, int move_flag, int source_square, int target_square, int capture)
+    {
+        // own piece bitboards offset (own piece = white piece + offset)
+        constexpr int offset = (color == white) ? 0 : 6;
 
-                    // pop ls1b of the current piece bitboard copy
-                    pop_bit(bitboard, source_square);
-                }
-            }
+        // pawn promotion
+        if ((color == white) ? target_square <= h8 : target_square >= a1)
+        {
+            if (move_flag != only_quiets)
+                add_move(move_list, encode_move(source_square, target_square, P + offset, Q + offset, capture, 0, 0, 0));
 
-            // generate rook moves
-            if ((side == white) ? piece == R : piece == r)
+            if (capture ? move_flag != only_quiets : move_flag != only_captures)
             {
-                // loop over source squares of piece bitboard copy
-                while (bitboard)
-                {
-                    // init source square
-                    source_square = get_ls1b_index(bitboard);
+                add_move(move_list, encode_move(source_square, target_square, P + offset, R + offset, capture, 0, 0, 0));
+                add_move(move_list, encode_move(source_square, target_square, P + offset, B + offset, capture, 0, 0, 0));
+                add_move(move_list, encode_move(source_square, target_square, P + offset, N + offset, capture, 0, 0, 0));
+            }
+        }
 
-                    // init piece attacks in order to get set of target squares
-                    attacks = Attacks::get_rook_attacks(source_square, occupancies[both]) & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
+        // capture or quiet pawn move
+        else if (capture ? move_flag != only_quiets : move_flag != only_captures)
+            add_move(move_list, encode_move(source_square, target_square, P + offset, 0, capture, 0, 0, 0));
+    }
 
-                    // loop over target squares available from generated attacks
-                    while (attacks)
-                    {
-                        // init target square
-                        target_square = get_ls1b_index(attacks);
+    // generate check evasions of the side to move known at compile time: king moves, captures of the checker
+    // and interpositions (only king moves on double check)
+    template <int color>
+    void generate_evasions(const Position& pos, MoveList& move_list, int move_flag, const CheckInfo& check_info)
+    {
+        // own piece bitboards offset (own piece = white piece + offset)
+        constexpr int offset = (color == white) ? 0 : 6;
 
-                        // quite move
-                        if (!get_bit(((side == white) ? occupancies[black] : occupancies[white]), target_square))
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+        // pawn push direction
+        constexpr int push = (color == white) ? -8 : 8;
 
-                        else
-                            // capture move
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+        // first square of the rank pawns land on after the double push
+        constexpr int double_push_rank = (color == white) ? a4 : a5;
 
-                        // pop ls1b in current attacks set
-                        pop_bit(attacks, target_square);
-                    }
+        // init move count
+        move_list.count = 0;
 
+        // define source & target squares
+        int source_square, target_square;
 
-                    // pop ls1b of the current piece bitboard copy
-                    pop_bit(bitboard, source_square);
-                }
-            }
+        // enemy pieces
+        U64 enemy_occupancy = pos.occupancies[color ^ 1];
 
-            // generate queen moves
-            if ((side == white) ? piece == Q : piece == q)
-            {
-                // loop over source squares of piece bitboard copy
-                while (bitboard)
-                {
-                    // init source square
-                    source_square = get_ls1b_index(bitboard);
+        // init king square
+        int king_square = check_info.king_square;
 
-                    // init piece attacks in order to get set of target squares
-                    attacks = Attacks::get_queen_attacks(source_square, occupancies[both]) & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
+        // init king target squares depending on move flag
+        U64 targets = (move_flag == only_captures) ? enemy_occupancy :
+                      (move_flag == only_quiets) ? ~pos.occupancies[both] : ~pos.occupancies[color];
 
-                    // loop over target squares available from generated attacks
-                    while (attacks)
-                    {
-                        // init target square
-                        target_square = get_ls1b_index(attacks);
+        // occupancy without the king (king doesn't block slider checks along the line it steps back on)
+        U64 occupancy = pos.occupancies[both] ^ (1ULL << king_square);
 
-                        // quite move
-                        if (!get_bit(((side == white) ? occupancies[black] : occupancies[white]), target_square))
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+        // generate king moves
+        for (U64 attacks = Attacks::king_attacks[king_square] & targets; attacks; pop_bit(attacks, target_square))
+        {
+            // init target square
+            target_square = get_ls1b_index(attacks);
 
-                        else
-                            // capture move
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+            // make sure king doesn't step into a check
+            if (is_square_attacked<color ^ 1>(pos, target_square, occupancy))
+                continue;
 
-                        // pop ls1b in current attacks set
-                        pop_bit(attacks, target_square);
-                    }
+            // quiet move or capture
+            int capture = get_bit(enemy_occupancy, target_square) ? 1 : 0;
 
+            add_move(move_list, encode_move(king_square, target_square, K + offset, 0, capture, 0, 0, 0));
+        }
 
-                    // pop ls1b of the current piece bitboard copy
-                    pop_bit(bitboard, source_square);
-                }
+        // on double check only king moves are possible
+        if (check_info.checkers & (check_info.checkers - 1))
+            return;
+
+        // init checker square
+        int checker_square = get_ls1b_index(check_info.checkers);
+
+        // pieces able to resolve the check (pinned pieces never can, neither can the king, it's done above)
+        U64 defenders = pos.occupancies[color] & ~check_info.pinned & ~pos.bitboards[K + offset];
+
+        // capture the checker
+        if (move_flag != only_quiets)
+        {
+            // loop over pieces attacking the checker
+            for (U64 attackers = attackers_to(pos, checker_square) & defenders; attackers; pop_bit(attackers, source_square))
+            {
+                // init source square
+                source_square = get_ls1b_index(attackers);
+
+                // init piece
+                int piece = pos.piece_on[source_square];
+
+                if (piece == P + offset)
+                    add_pawn_moves<color>(move_list, move_flag, source_square, checker_square, 1);
+
+                else
+                    add_move(move_list, encode_move(source_square, checker_square, piece, 0, 1, 0, 0, 0));
             }
 
-            // generate king moves
-            if ((side == white) ? piece == K : piece == k)
+            // capture the checker (or block the check) enpassant
+            if (pos.enpassant != no_sq)
             {
-                // loop over source squares of piece bitboard copy
-                while (bitboard)
+                // loop over pawns attacking enpassant square
+                for (U64 attackers = Attacks::pawn_attacks[color ^ 1][pos.enpassant] & pos.bitboards[P + offset] & defenders; attackers; pop_bit(attackers, source_square))
                 {
                     // init source square
-                    source_square = get_ls1b_index(bitboard);
+                    source_square = get_ls1b_index(attackers);
 
-                    // init piece attacks in order to get set of target squares
-                    attacks = Attacks::king_attacks[source_square] & ((side == white) ? ~occupancies[white] : ~occupancies[black]);
+                    // make sure the capture resolves the check
+                    if (is_enpassant_legal<color>(pos, check_info, source_square))
+                        add_move(move_list, encode_move(source_square, pos.enpassant, P + offset, 0, 1, 0, 1, 0));
+                }
+            }
+        }
 
-                    // loop over target squares available from generated attacks
-                    while (attacks)
-                    {
-                        // init target square
-                        target_square = get_ls1b_index(attacks);
+        // block the check
+        for (U64 block_squares = Attacks::between_masks[king_square][checker_square]; block_squares; pop_bit(block_squares, target_square))
+        {
+            // init target square
+            target_square = get_ls1b_index(block_squares);
 
-                        // quite move
-                        if (!get_bit(((side == white) ? occupancies[black] : occupancies[white]), target_square))
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 0, 0, 0, 0));
+            // pawn pushes (queen promotions are searched along with captures)
+            source_square = target_square - push;
 
-                        else
-                            // capture move
-                            add_move(move_list, encode_move(source_square, target_square, piece, 0, 1, 0, 0, 0));
+            if (get_bit(pos.bitboards[P + offset] & defenders, source_square))
+                add_pawn_moves<color>(move_list, move_flag, source_square, target_square, 0);
 
-                        // pop ls1b in current attacks set
-                        pop_bit(attacks, target_square);
-                    }
+            // the rest of the blocks are quiet moves
+            if (move_flag == only_captures)
+                continue;
 
-                    // pop ls1b of the current piece bitboard copy
-                    pop_bit(bitboard, source_square);
-                }
+            // double pawn push
+            if (target_square >= double_push_rank && target_square <= double_push_rank + 7 &&
+                get_bit(pos.bitboards[P + offset] & defenders, target_square - 2 * push) && !get_bit(pos.occupancies[both], target_square - push))
+                add_move(move_list, encode_move(target_square - 2 * push, target_square, P + offset, 0, 0, 1, 0, 0));
+
+            // pieces moving to the block square
+            U64 blockers = ((Attacks::knight_attacks[target_square] & pos.bitboards[N + offset]) |
+                            (Attacks::get_bishop_attacks(target_square, pos.occupancies[both]) & (pos.bitboards[B + offset] | pos.bitboards[Q + offset])) |
+                            (Attacks::get_rook_attacks(target_square, pos.occupancies[both]) & (pos.bitboards[R + offset] | pos.bitboards[Q + offset]))) & defenders;
+
+            // loop over blocking pieces
+            for (; blockers; pop_bit(blockers, source_square))
+            {
+                // init source square
+                source_square = get_ls1b_index(blockers);
+
+                add_move(move_list, encode_move(source_square, target_square, pos.piece_on[source_square], 0, 0, 0, 0, 0));
             }
         }
     }
 
-    // make move on chess board
-    int make_move(int move, int move_flag)
+    // generate all legal moves (or only captures & queen promotions / only the rest of the moves depending on move flag)
+    void generate_moves(const Position& pos, MoveList& move_list, int move_flag, const CheckInfo& check_info)
+    {
+        // king is in check, generate evasions only
+        if (check_info.checkers)
+            (pos.side == white) ? generate_evasions<white>(pos, move_list, move_flag, check_info) :
+                                  generate_evasions<black>(pos, move_list, move_flag, check_info);
+
+        else
+            (pos.side == white) ? generate_moves<white>(pos, move_list, move_flag, check_info) :
+                                  generate_moves<black>(pos, move_list, move_flag, check_info);
+    }
+
+    // generate all legal moves (or only captures & queen promotions / only the rest of the moves depending on move flag)
+    void generate_moves(const Position& pos, MoveList& move_list, int move_flag = all_moves)
     {
-        // quite moves
-        if (move_flag == all_moves)
+        // init check & pin information
+        CheckInfo check_info;
+        init_check_info(pos, check_info);
+
+        // generate moves
+        generate_moves(pos, move_list, move_flag, check_info);
+    }
+
+    // generate captures, en passant captures & queen promotions (quiescence search moves)
+    void generate_captures(const Position& pos, MoveList& move_list, const CheckInfo& check_info)
+    {
+        // generate the capture stage of the move generator
+        generate_moves(pos, move_list, only_captures, check_info);
+    }
+
+    // generate captures, en passant captures & queen promotions (quiescence search moves)
+    void generate_captures(const Position& pos, MoveList& move_list)
+    {
+        // init check & pin information
+        CheckInfo check_info;
+        init_check_info(pos, check_info);
+
+        // generate captures
+        generate_captures(pos, move_list, check_info);
+    }
+
+    // does the (legal) move of the side to move give check (check info has to be initialized for current position)
+    int gives_check(const Position& pos, const CheckInfo& check_info, int move)
+    {
+        // parse move
+        int source_square = get_move_source(move);
+        int target_square = get_move_target(move);
+        int piece = get_move_piece(move);
+        int promoted_piece = get_move_promoted(move);
+
+        // own piece bitboards offset (own piece = white piece + offset)
+        int offset = (pos.side == white) ? 0 : 6;
+
+        // init enemy king square
+        int king_square = check_info.enemy_king_square;
+
+        // direct check (promoted piece attacks through the square the pawn has left)
+        if (promoted_piece)
         {
-            // preserve board state
-            copy_board();
-
-            // parse move
-            int source_square = get_move_source(move);
-            int target_square = get_move_target(move);
-            int piece = get_move_piece(move);
-            int promoted_piece = get_move_promoted(move);
-            int capture = get_move_capture(move);
-            int double_push = get_move_double(move);
-            int enpass = get_move_enpassant(move);
-            int castling = get_move_castling(move);
-
-            // move piece
-            pop_bit(bitboards[piece], source_square);
-            set_bit(bitboards[piece], target_square);
-
-            // hash piece
-            hash_key ^= Zobrist::piece_keys[piece][source_square]; // remove piece from source square in hash key
-            hash_key ^= Zobrist::piece_keys[piece][target_square]; // set piece to the target square in hash key
-
-            // handling capture moves
-            if (capture)
+            // occupancy after the move
+            U64 occupancy = pos.occupancies[both] ^ (1ULL << source_square);
+
+            switch (promoted_piece - offset)
             {
-                // pick up bitboard piece index ranges depending on side
-                int start_piece, end_piece;
+            case N: if (Attacks::knight_attacks[target_square] & (1ULL << king_square)) return 1; break;
+            case B: if (Attacks::get_bishop_attacks(target_square, occupancy) & (1ULL << king_square)) return 1; break;
+            case R: if (Attacks::get_rook_attacks(target_square, occupancy) & (1ULL << king_square)) return 1; break;
+            case Q: if (Attacks::get_queen_attacks(target_square, occupancy) & (1ULL << king_square)) return 1; break;
+            }
+        }
 
-                // white to move
-                if (side == white)
-                {
-                    start_piece = p;
-                    end_piece = k;
-                }
+        else if (get_bit(check_info.check_squares[piece - offset], target_square))
+            return 1;
 
-                // black to move
-                else
-                {
-                    start_piece = P;
-                    end_piece = K;
-                }
+        // discovered check (piece moves off the line between own slider and enemy king)
+        if (get_bit(check_info.discovered_candidates, source_square) && !get_bit(Attacks::line_masks[king_square][source_square], target_square))
+            return 1;
 
-                // loop over bitboards opposite to the current side to move
-                for (int bb_piece = start_piece; bb_piece <= end_piece; bb_piece++)
-                {
-                    // if there's a piece on the target square
-                    if (get_bit(bitboards[bb_piece], target_square))
-                    {
-                        // remove it from corresponding bitboard
-                        pop_bit(bitboards[bb_piece], target_square);
+        // enpassant capture may discover check by removing the captured pawn as well
+        if (get_move_enpassant(move))
+        {
+            // init captured pawn square
+            int captured_square = (pos.side == white) ? target_square + 8 : target_square - 8;
 
-                        // remove the piece from hash key
-                        hash_key ^= Zobrist::piece_keys[bb_piece][target_square];
+            // occupancy after the capture
+            U64 occupancy = pos.occupancies[both] ^ (1ULL << source_square) ^ (1ULL << captured_square) ^ (1ULL << target_square);
 
-                        break;
-                    }
-                }
-            }
+            // own sliders attacking enemy king
+            return ((Attacks::get_bishop_attacks(king_square, occupancy) & (pos.bitboards[B + offset] | pos.bitboards[Q + offset])) |
+                    (Attacks::get_rook_attacks(king_square, occupancy) & (pos.bitboards[R + offset] | pos.bitboards[Q + offset]))) != 0;
+        }
 
-            // handle pawn promotions
-            if (promoted_piece)
-            {
-                // white to move
-                if (side == white)
-                {
-                    // erase the pawn from the target square
-                    pop_bit(bitboards[P], target_square);
+        // castling rook may give check
+        if (get_move_castling(move))
+        {
+            // init rook squares
+            int rook_source = (target_square > source_square) ? source_square + 3 : source_square - 4;
+            int rook_target = (target_square > source_square) ? source_square + 1 : source_square - 1;
 
-                    // remove pawn from hash key
-                    hash_key ^= Zobrist::piece_keys[P][target_square];
-                }
+            // occupancy after castling
+            U64 occupancy = pos.occupancies[both] ^ (1ULL << source_square) ^ (1ULL << target_square) ^ (1ULL << rook_source) ^ (1ULL << rook_target);
 
-                // black to move
-                else
-                {
-                    // erase the pawn from the target square
-                    pop_bit(bitboards[p], target_square);
+            return (Attacks::get_rook_attacks(rook_target, occupancy) & (1ULL << king_square)) != 0;
+        }
 
-                    // remove pawn from hash key
-                    hash_key ^= Zobrist::piece_keys[p][target_square];
-                }
+        // move doesn't give check
+        return 0;
+    }
 
-                // set up promoted piece on chess board
-                set_bit(bitboards[promoted_piece], target_square);
+    // expand compact move into a move on current board (0 if there's no piece to move),
+    // the result still has to be validated by is_pseudo_legal & is_legal
+    int expand_move(const Position& pos, U16 compact)
+    {
+        // no move
+        if (compact == 0)
+            return 0;
+
+        // init source & target squares, promoted & moving piece
+        int source_square = get_move_source(compact);
+        int target_square = get_move_target(compact);
+        int promoted_piece = get_compact_promoted(compact);
+        int piece = pos.piece_on[source_square];
+
+        // source square is empty
+        if (piece == no_piece)
+            return 0;
+
+        // init move flags
+        int capture = pos.piece_on[target_square] != no_piece;
+        int double_push = 0, enpassant = 0, castling = 0;
+
+        // pawn moves: double push by distance, enpassant by diagonal move to enpassant square
+        if (piece == P || piece == p)
+        {
+            double_push = abs(target_square - source_square) == 16;
 
-                // add promoted piece into the hash key
-                hash_key ^= Zobrist::piece_keys[promoted_piece][target_square];
+            if (target_square == pos.enpassant && (source_square & 7) != (target_square & 7))
+            {
+                capture = 1;
+                enpassant = 1;
             }
+        }
 
-            // handle enpassant captures
-            if (enpass)
-            {
-                // erase the pawn depending on side to move
-                (side == white) ? pop_bit(bitboards[p], target_square + 8) :
-                    pop_bit(bitboards[P], target_square - 8);
+        // castling by king moving two squares
+        else if (piece == K || piece == k)
+            castling = abs(target_square - source_square) == 2;
 
-                // white to move
-                if (side == white)
-                {
-                    // remove captured pawn
-                    pop_bit(bitboards[p], target_square + 8);
+        // encode move
+        return encode_move(source_square, target_square, piece, promoted_piece, capture, double_push, enpassant, castling);
+    }
 
-                    // remove pawn from hash key
-                    hash_key ^= Zobrist::piece_keys[p][target_square + 8];
-                }
+    // is the move (e.g. hash or killer move coming from another position) possible on current board,
+    // not taking pins & checks into account (see is_legal)
+    int is_pseudo_legal(const Position& pos, int move)
+    {
+        // parse move
+        int source_square = get_move_source(move);
+        int target_square = get_move_target(move);
+        int piece = get_move_piece(move);
+        int promoted_piece = get_move_promoted(move);
+        int capture = get_move_capture(move);
+        int double_push = get_move_double(move);
+        int enpass = get_move_enpassant(move);
+        int castling = get_move_castling(move);
+
+        // own piece bitboards offset (own piece = white piece + offset)
+        int offset = (pos.side == white) ? 0 : 6;
+
+        // empty move
+        if (move == 0)
+            return 0;
+
+        // moving piece has to be the side to move piece standing on the source square
+        if (piece < P + offset || piece > K + offset || pos.piece_on[source_square] != piece)
+            return 0;
+
+        // target square must hold an enemy piece on captures (other than enpassant) and be empty otherwise
+        if (enpass ? pos.piece_on[target_square] != no_piece :
+            capture ? !get_bit(pos.occupancies[pos.side ^ 1], target_square) :
+                      get_bit(pos.occupancies[both], target_square))
+            return 0;
+
+        // castling
+        if (castling)
+        {
+            // castling rights & squares
+            int king_side = (pos.side == white) ? wk : bk;
+            int queen_side = (pos.side == white) ? wq : bq;
+            int king_from = (pos.side == white) ? e1 : e8;
 
-                // black to move
-                else
-                {
-                    // remove captured pawn
-                    pop_bit(bitboards[P], target_square - 8);
+            if (piece != K + offset || source_square != king_from || capture || promoted_piece || double_push || enpass)
+                return 0;
 
-                    // remove pawn from hash key
-                    hash_key ^= Zobrist::piece_keys[P][target_square - 8];
-                }
-            }
+            // king side castling is available and squares between king and king's rook are empty
+            if (target_square == king_from + 2)
+                return (pos.castle & king_side) && !get_bit(pos.occupancies[both], king_from + 1);
+
+            // queen side castling is available and squares between king and queen's rook are empty
+            if (target_square == king_from - 2)
+                return (pos.castle & queen_side) && !get_bit(pos.occupancies[both], king_from - 1) && !get_bit(pos.occupancies[both], king_from - 3);
+
+            return 0;
+        }
+
+        // pawn moves
+        if (piece == P + offset)
+        {
+            // pawn push direction
+            int push = (pos.side == white) ? -8 : 8;
+
+            // pawns promote on the last rank (and only there)
+            int last_rank = (pos.side == white) ? target_square <= h8 : target_square >= a1;
 
-            // hash enpassant if available (remove enpassant square from hash key )
-            if (enpassant != no_sq) hash_key ^= Zobrist::enpassant_keys[enpassant];
+            if (last_rank ? (promoted_piece < N + offset || promoted_piece > Q + offset) : promoted_piece != 0)
+                return 0;
+
+            // enpassant capture
+            if (enpass)
+                return capture && !double_push && target_square == pos.enpassant &&
+                       get_bit(Attacks::pawn_attacks[pos.side][source_square], target_square);
 
-            // reset enpassant square
-            enpassant = no_sq;
+            // pawn capture
+            if (capture)
+                return !double_push && get_bit(Attacks::pawn_attacks[pos.side][source_square], target_square);
 
-            // handle double pawn push
+            // double pawn push
             if (double_push)
-            {
-                // white to move
-                if (side == white)
-                {
-                    // set enpassant square
-                    enpassant = target_square + 8;
+                return target_square == source_square + 2 * push &&
+                       (pos.side == white ? (source_square >= a2 && source_square <= h2) : (source_square >= a7 && source_square <= h7)) &&
+                       !get_bit(pos.occupancies[both], source_square + push);
 
-                    // hash enpassant
-                    hash_key ^= Zobrist::enpassant_keys[target_square + 8];
-                }
+            // single pawn push
+            return target_square == source_square + push;
+        }
 
-                // black to move
-                else
-                {
-                    // set enpassant square
-                    enpassant = target_square - 8;
+        // the rest of the pieces don't promote, push two squares ahead or capture enpassant
+        if (promoted_piece || double_push || enpass)
+            return 0;
 
-                    // hash enpassant
-                    hash_key ^= Zobrist::enpassant_keys[target_square - 8];
-                }
-            }
+        // init piece attacks
+        U64 attacks = 0ULL;
 
-            // handle castling moves
-            if (castling)
-            {
-                // switch target square
-                switch (target_square)
-                {
-                    // white castles king side
-                case (g1):
-                    // move H rook
-                    pop_bit(bitboards[R], h1);
-                    set_bit(bitboards[R], f1);
-                    break;
-
-                    // white castles queen side
-                case (c1):
-                    // move A rook
-                    pop_bit(bitboards[R], a1);
-                    set_bit(bitboards[R], d1);
-                    break;
-
-                    // black castles king side
-                case (g8):
-                    // move H rook
-                    pop_bit(bitboards[r], h8);
-                    set_bit(bitboards[r], f8);
-                    break;
-
-                    // black castles queen side
-                case (c8):
-                    // move A rook
-                    pop_bit(bitboards[r], a8);
-                    set_bit(bitboards[r], d8);
-                    break;
-                }
-            }
+        switch (piece - offset)
+        {
+        case N: attacks = Attacks::knight_attacks[source_square]; break;
+        case B: attacks = Attacks::get_bishop_attacks(source_square, pos.occupancies[both]); break;
+        case R: attacks = Attacks::get_rook_attacks(source_square, pos.occupancies[both]); break;
+        case Q: attacks = Attacks::get_queen_attacks(source_square, pos.occupancies[both]); break;
+        case K: attacks = Attacks::king_attacks[source_square]; break;
+        }
+
+        // piece has to reach the target square
+        return get_bit(attacks, target_square) ? 1 : 0;
+    }
+
+    // is the pseudo legal move legal (check info has to be initialized for current position)
+    int is_legal(const Position& pos, const CheckInfo& check_info, int move)
+    {
+        // parse move
+        int source_square = get_move_source(move);
+        int target_square = get_move_target(move);
+
+        // castling: king is not in check and doesn't pass or land on attacked squares
+        if (get_move_castling(move))
+            return !check_info.checkers &&
+                   !is_square_attacked(pos, (source_square + target_square) / 2, pos.side ^ 1) &&
+                   !is_square_attacked(pos, target_square, pos.side ^ 1);
+
+        // king moves: king doesn't step into a check (king itself doesn't block attacks)
+        if (source_square == check_info.king_square)
+            return !is_square_attacked(pos, target_square, pos.side ^ 1, pos.occupancies[both] ^ (1ULL << source_square));
+
+        // enpassant capture
+        if (get_move_enpassant(move))
+            return (pos.side == white) ? is_enpassant_legal<white>(pos, check_info, source_square) :
+                                         is_enpassant_legal<black>(pos, check_info, source_square);
+
+        // the rest of the moves have to resolve the check & keep pinned pieces on the pin line
+        return get_bit(get_legal_targets(check_info, source_square), target_square) ? 1 : 0;
+    }
+
+    // move a piece from the source to the target square (bitboards, occupancies & pieces by square)
+    static inline void move_piece(Position& pos, int piece, int color, int source_square, int target_square)
+    {
+        // source & target squares bitboard
+        U64 from_to = (1ULL << source_square) | (1ULL << target_square);
+
+        // move piece
+        pos.bitboards[piece] ^= from_to;
+        pos.occupancies[color] ^= from_to;
+        pos.occupancies[both] ^= from_to;
+        pos.piece_on[source_square] = no_piece;
+        pos.piece_on[target_square] = piece;
+    }
 
-            // hash castling
-            hash_key ^= Zobrist::castle_keys[castle];
+    // put a piece on the empty square (bitboards, occupancies & pieces by square)
+    static inline void put_piece(Position& pos, int piece, int color, int square)
+    {
+        // square bitboard
+        U64 square_bit = 1ULL << square;
+
+        // put piece
+        pos.bitboards[piece] ^= square_bit;
+        pos.occupancies[color] ^= square_bit;
+        pos.occupancies[both] ^= square_bit;
+        pos.piece_on[square] = piece;
+    }
 
-            // update castling rights
-            castle &= castling_rights[source_square];
-            castle &= castling_rights[target_square];
+    // remove a piece from the square (bitboards, occupancies & pieces by square)
+    static inline void remove_piece(Position& pos, int piece, int color, int square)
+    {
+        // square bitboard
+        U64 square_bit = 1ULL << square;
+
+        // remove piece
+        pos.bitboards[piece] ^= square_bit;
+        pos.occupancies[color] ^= square_bit;
+        pos.occupancies[both] ^= square_bit;
+        pos.piece_on[square] = no_piece;
+    }
 
-            // hash castling
-            hash_key ^= Zobrist::castle_keys[castle];
+    // make (legal) move of the side to move known at compile time, saving what unmake_move needs into the undo record
+    template <int color>
+    void make_move(Position& pos, int move, Undo& undo)
+    {
+        // own & enemy piece bitboards offsets (piece = white piece + offset)
+        constexpr int offset = (color == white) ? 0 : 6;
+        constexpr int enemy_offset = (color == white) ? 6 : 0;
+
+        // square behind the pawn that has moved two squares ahead (enpassant square or captured pawn square)
+        constexpr int behind = (color == white) ? 8 : -8;
+
+        // castling rook squares
+        constexpr int king_side_rook = (color == white) ? h1 : h8;
+        constexpr int queen_side_rook = (color == white) ? a1 : a8;
+        constexpr int king_side_rook_to = (color == white) ? f1 : f8;
+        constexpr int queen_side_rook_to = (color == white) ? d1 : d8;
+        constexpr int king_side_to = (color == white) ? g1 : g8;
+
+        // parse move
+        int source_square = get_move_source(move);
+        int target_square = get_move_target(move);
+        int piece = get_move_piece(move);
+        int promoted_piece = get_move_promoted(move);
+        int capture = get_move_capture(move);
+        int double_push = get_move_double(move);
+        int enpass = get_move_enpassant(move);
+        int castling = get_move_castling(move);
+
+        // save irreversible state
+        undo.captured_piece = no_piece;
+        undo.enpassant = pos.enpassant;
+        undo.castle = pos.castle;
+        undo.hash_key = pos.hash_key;
+
+        // handle enpassant captures
+        if (enpass)
+        {
+            // remove captured pawn
+            remove_piece(pos, P + enemy_offset, color ^ 1, target_square + behind);
 
-            // reset occupancies
-            memset(occupancies, 0ULL, 24);
+            // remove pawn from hash key
+            pos.hash_key ^= Zobrist::piece_keys[P + enemy_offset][target_square + behind];
+        }
 
-            // loop over white pieces bitboards
-            for (int bb_piece = P; bb_piece <= K; bb_piece++)
-                // update white occupancies
-                occupancies[white] |= bitboards[bb_piece];
+        // handling capture moves
+        else if (capture)
+        {
+            // remember captured piece
+            undo.captured_piece = pos.piece_on[target_square];
 
-            // loop over black pieces bitboards
-            for (int bb_piece = p; bb_piece <= k; bb_piece++)
-                // update black occupancies
-                occupancies[black] |= bitboards[bb_piece];
+            // remove it from corresponding bitboard
+            remove_piece(pos, undo.captured_piece, color ^ 1, target_square);
 
-            // update both sides occupancies
-            occupancies[both] |= occupancies[white];
-            occupancies[both] |= occupancies[black];
+            // remove the piece from hash key
+            pos.hash_key ^= Zobrist::piece_keys[undo.captured_piece][target_square];
+        }
 
-            // change side
-            side ^= 1;
+        // move piece
+        move_piece(pos, piece, color, source_square, target_square);
 
-            // hash side
-            hash_key ^= Zobrist::side_key;
+        // hash piece
+        pos.hash_key ^= Zobrist::piece_keys[piece][source_square] ^ Zobrist::piece_keys[piece][target_square];
 
-            // make sure that king has not been exposed into a check
-            if (is_square_attacked((side == white) ? get_ls1b_index(bitboards[k]) : get_ls1b_index(bitboards[K]), side))
-            {
-                // take move back
-                take_back();
+        // handle pawn promotions
+        if (promoted_piece)
+        {
+            // erase the pawn from the target square
+            remove_piece(pos, piece, color, target_square);
 
-                // return illegal move
-                return 0;
+            // set up promoted piece on chess board
+            put_piece(pos, promoted_piece, color, target_square);
+
+            // replace pawn with promoted piece in hash key
+            pos.hash_key ^= Zobrist::piece_keys[piece][target_square] ^ Zobrist::piece_keys[promoted_piece][target_square];
+        }
+
+        // hash enpassant if available (remove enpassant square from hash key )
+        if (pos.enpassant != no_sq) pos.hash_key ^= Zobrist::enpassant_keys[pos.enpassant];
+
+        // reset enpassant square
+        pos.enpassant = no_sq;
+
+        // handle double pawn push
+        if (double_push)
+        {
+            // set enpassant square behind the pawn
+            pos.enpassant = target_square + behind;
+
+            // hash enpassant
+            pos.hash_key ^= Zobrist::enpassant_keys[pos.enpassant];
+        }
+
+        // handle castling moves (move the rook)
+        if (castling)
+        {
+            // king side
+            if (target_square == king_side_to)
+            {
+                move_piece(pos, R + offset, color, king_side_rook, king_side_rook_to);
+                pos.hash_key ^= Zobrist::piece_keys[R + offset][king_side_rook] ^ Zobrist::piece_keys[R + offset][king_side_rook_to];
             }
 
-            //
+            // queen side
             else
-                // return legal move
-                return 1;
+            {
+                move_piece(pos, R + offset, color, queen_side_rook, queen_side_rook_to);
+                pos.hash_key ^= Zobrist::piece_keys[R + offset][queen_side_rook] ^ Zobrist::piece_keys[R + offset][queen_side_rook_to];
+            }
+        }
 
+        // hash castling
+        pos.hash_key ^= Zobrist::castle_keys[pos.castle];
 
-        }
+        // update castling rights
+        pos.castle &= castling_rights[source_square];
+        pos.castle &= castling_rights[target_square];
 
-        // capture moves
-        else
+        // hash castling
+        pos.hash_key ^= Zobrist::castle_keys[pos.castle];
+
+        // change side
+        pos.side = color ^ 1;
+
+        // hash side
+        pos.hash_key ^= Zobrist::side_key;
+    }
+
+    // make (legal) move on chess board, saving what unmake_move needs into the undo record
+    void make_move(Position& pos, int move, Undo& undo)
+    {
+        (pos.side == white) ? make_move<white>(pos, move, undo) : make_move<black>(pos, move, undo);
+    }
+
+    // take back the move of the given side (known at compile time) restoring the board state from the undo record
+    template <int color>
+    void unmake_move(Position& pos, int move, const Undo& undo)
+    {
+        // own & enemy piece bitboards offsets (piece = white piece + offset)
+        constexpr int offset = (color == white) ? 0 : 6;
+        constexpr int enemy_offset = (color == white) ? 6 : 0;
+
+        // square of the pawn captured enpassant relative to the target square
+        constexpr int behind = (color == white) ? 8 : -8;
+
+        // castling rook squares
+        constexpr int king_side_rook = (color == white) ? h1 : h8;
+        constexpr int queen_side_rook = (color == white) ? a1 : a8;
+        constexpr int king_side_rook_to = (color == white) ? f1 : f8;
+        constexpr int queen_side_rook_to = (color == white) ? d1 : d8;
+        constexpr int king_side_to = (color == white) ? g1 : g8;
+
+        // parse move
+        int source_square = get_move_source(move);
+        int target_square = get_move_target(move);
+        int piece = get_move_piece(move);
+        int promoted_piece = get_move_promoted(move);
+
+        // change side back
+        pos.side = color;
+
+        // put castling rook back
+        if (get_move_castling(move))
         {
-            // make sure move is the capture
-            if (get_move_capture(move))
-                make_move(move, all_moves);
+            if (target_square == king_side_to)
+                move_piece(pos, R + offset, color, king_side_rook_to, king_side_rook);
 
-            // otherwise the move is not a capture
             else
-                // don't make it
-                return 0;
+                move_piece(pos, R + offset, color, queen_side_rook_to, queen_side_rook);
+        }
+
+        // turn promoted piece back into the pawn
+        if (promoted_piece)
+        {
+            remove_piece(pos, promoted_piece, color, target_square);
+            put_piece(pos, piece, color, target_square);
         }
 
+        // move piece back
+        move_piece(pos, piece, color, target_square, source_square);
+
+        // put enpassant captured pawn back
+        if (get_move_enpassant(move))
+            put_piece(pos, P + enemy_offset, color ^ 1, target_square + behind);
+
+        // put captured piece back
+        else if (undo.captured_piece != no_piece)
+            put_piece(pos, undo.captured_piece, color ^ 1, target_square);
+
+        // restore irreversible state (including the hash key)
+        pos.enpassant = undo.enpassant;
+        pos.castle = undo.castle;
+        pos.hash_key = undo.hash_key;
+    }
+
+    // take move back restoring the board state from the undo record
+    void unmake_move(Position& pos, int move, const Undo& undo)
+    {
+        // the move has been made by the side that is not to move now
+        (pos.side == black) ? unmake_move<white>(pos, move, undo) : unmake_move<black>(pos, move, undo);
+    }
+
+    // make null move (pass the turn to the opponent)
+    void make_null_move(Position& pos, Undo& undo)
+    {
+        // save irreversible state
+        undo.captured_piece = no_piece;
+        undo.enpassant = pos.enpassant;
+        undo.castle = pos.castle;
+        undo.hash_key = pos.hash_key;
+
+        // remove enpassant square from hash key
+        if (pos.enpassant != no_sq) pos.hash_key ^= Zobrist::enpassant_keys[pos.enpassant];
+
+        // reset enpassant capture square
+        pos.enpassant = no_sq;
+
+        // switch the side
+        pos.side ^= 1;
+
+        // hash side
+        pos.hash_key ^= Zobrist::side_key;
+    }
+
+    // take null move back
+    void unmake_null_move(Position& pos, const Undo& undo)
+    {
+        // switch the side back
+        pos.side ^= 1;
+
+        // restore irreversible state
+        pos.enpassant = undo.enpassant;
+        pos.hash_key = undo.hash_key;
     }
 }
\ No newline at end of file